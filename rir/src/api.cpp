@@ -15,12 +15,17 @@
 #include "compiler/parameter.h"
 #include "compiler/test/PirCheck.h"
 #include "compiler/test/PirTests.h"
+#include "compiler/util/apply_intrinsics.h"
 #include "interpreter/interp_incl.h"
+#include "interpreter/sampling_profiler.h"
 #include "ir/BC.h"
 #include "ir/Compiler.h"
+#include "runtime_stats.h"
 
+#include <fstream>
 #include <list>
 #include <memory>
+#include <sstream>
 #include <string>
 
 using namespace rir;
@@ -298,6 +303,7 @@ SEXP pirCompile(SEXP what, const Context& assumptions, const std::string& name,
                            cmp.optimizeModule();
 
                            auto fun = backend.compile(c);
+                           RuntimeStats::count(RuntimeStats::Compilations);
 
                            // Install
                            if (dryRun)
@@ -307,6 +313,7 @@ SEXP pirCompile(SEXP what, const Context& assumptions, const std::string& name,
                            DispatchTable::unpack(BODY(what))->insert(fun);
                        },
                        [&]() {
+                           RuntimeStats::count(RuntimeStats::CompileFailures);
                            if (debug.includes(pir::DebugFlag::ShowWarnings))
                                std::cerr << "Compilation failed\n";
                        },
@@ -331,6 +338,31 @@ REXPORT SEXP rirInvocationCount(SEXP what) {
     return res;
 }
 
+REXPORT SEXP rirTypeFeedback(SEXP what) {
+    if (!isValidClosureSEXP(what)) {
+        Rf_error("not a compiled closure");
+    }
+    auto body = DispatchTable::unpack(BODY(what))->baseline()->body();
+
+    std::vector<std::string> feedback;
+    for (auto pc = body->code(); pc < body->endCode(); pc = BC::next(pc)) {
+        if (*pc != Opcode::record_type_)
+            continue;
+        std::stringstream out;
+        BC::decode(pc, body).immediate.typeFeedback.print(out);
+        feedback.push_back(out.str());
+    }
+
+    SEXP res = PROTECT(Rf_allocVector(STRSXP, feedback.size()));
+    for (size_t i = 0; i < feedback.size(); ++i)
+        SET_STRING_ELT(res, i, Rf_mkChar(feedback[i].c_str()));
+    SEXP stable = PROTECT(
+        Rf_ScalarLogical(body->flags.contains(Code::StableFeedback)));
+    Rf_setAttrib(res, Rf_install("stable"), stable);
+    UNPROTECT(2);
+    return res;
+}
+
 REXPORT SEXP pirCompileWrapper(SEXP what, SEXP name, SEXP debugFlags,
                                SEXP debugStyle) {
     if (debugFlags != R_NilValue &&
@@ -536,8 +568,56 @@ REXPORT SEXP rirCreateSimpleIntContext() {
     return res;
 }
 
+REXPORT SEXP rirProfileStart(SEXP interval) {
+    if (TYPEOF(interval) != REALSXP || LENGTH(interval) != 1)
+        Rf_error("interval should be a number");
+    SamplingProfiler::start(REAL(interval)[0]);
+    return R_NilValue;
+}
+
+REXPORT SEXP rirProfileStop() {
+    SamplingProfiler::stop();
+    return R_NilValue;
+}
+
+REXPORT SEXP rirProfileWrite(SEXP fileSexp, SEXP formatSexp) {
+    if (TYPEOF(fileSexp) != STRSXP || LENGTH(fileSexp) != 1)
+        Rf_error("file should be a path");
+    if (TYPEOF(formatSexp) != STRSXP || LENGTH(formatSexp) != 1)
+        Rf_error("format should be rprof or collapsed");
+    std::string format = CHAR(STRING_ELT(formatSexp, 0));
+    std::ofstream out(CHAR(STRING_ELT(fileSexp, 0)));
+    if (!out)
+        Rf_error("cannot open %s", CHAR(STRING_ELT(fileSexp, 0)));
+    if (format == "rprof")
+        SamplingProfiler::writeRprof(out);
+    else if (format == "collapsed")
+        SamplingProfiler::writeCollapsed(out);
+    else
+        Rf_error("unknown format %s", format.c_str());
+    return R_NilValue;
+}
+
+REXPORT SEXP rirProfileSummary() { return SamplingProfiler::summary(); }
+
+REXPORT SEXP rirStats(SEXP reset) {
+    auto res = PROTECT(Rf_allocVector(REALSXP, RuntimeStats::NumCounters));
+    auto names = PROTECT(Rf_allocVector(STRSXP, RuntimeStats::NumCounters));
+    for (unsigned i = 0; i < RuntimeStats::NumCounters; ++i) {
+        auto c = (RuntimeStats::Counter)i;
+        REAL(res)[i] = RuntimeStats::get(c);
+        SET_STRING_ELT(names, i, Rf_mkChar(RuntimeStats::name(c)));
+    }
+    Rf_setAttrib(res, R_NamesSymbol, names);
+    if (Rf_asLogical(reset) == TRUE)
+        RuntimeStats::reset();
+    UNPROTECT(2);
+    return res;
+}
+
 bool startup() {
     initializeRuntime();
+    pir::ApplyIntrinsics::initialize();
     return true;
 }
 
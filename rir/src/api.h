@@ -12,6 +12,7 @@ extern int R_ENABLE_JIT;
 extern rir::pir::DebugOptions PirDebug;
 
 REXPORT SEXP rirInvocationCount(SEXP what);
+REXPORT SEXP rirTypeFeedback(SEXP what);
 REXPORT SEXP pirCompileWrapper(SEXP closure, SEXP name, SEXP debugFlags,
                                SEXP debugStyle);
 REXPORT SEXP rirCompile(SEXP what, SEXP env);
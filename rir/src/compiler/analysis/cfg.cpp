@@ -500,10 +500,10 @@ UsesTree::UsesTree(Code* start) {
 }
 
 const UsesTree::DependenciesList& UsesTree::at(Instruction* i) const {
-    if (uses.count(i))
-        return uses.at(i);
-    else
-        return empty;
+    auto u = uses.find(i);
+    if (u != uses.end())
+        return u->second;
+    return empty;
 }
 } // namespace pir
 } // namespace rir
@@ -0,0 +1,101 @@
+#include "escape.h"
+#include "../pir/pir_impl.h"
+#include "../util/visitor.h"
+#include "cfg.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace rir {
+namespace pir {
+
+EscapeAnalysis::EscapeAnalysis(Code* code) {
+    UsesTree uses(code);
+
+    std::vector<Instruction*> allocations;
+    Visitor::run(code->entry, [&](Instruction* i) {
+        if (MkEnv::Cast(i) || MkArg::Cast(i)) {
+            allocations.push_back(i);
+            result[i] = Escape::OnDeopt;
+        }
+    });
+
+    // How the allocation `a` escapes, if `v` (which is `a` or a cast of it) is
+    // used by `use`.
+    std::function<Escape(Instruction*, Instruction*, Instruction*)> through =
+        [&](Instruction* a, Instruction* v, Instruction* use) {
+            if (use->bb()->isDeopt() || FrameState::Cast(use))
+                return Escape::OnDeopt;
+
+            if (CastType::Cast(use)) {
+                auto res = Escape::OnDeopt;
+                for (auto u : uses.at(use))
+                    res = std::max(res, through(a, use, u));
+                return res;
+            }
+
+            // Apart from the env slot, v must not be used as an argument
+            auto onlyAsEnv = [&]() {
+                if (!use->hasEnv() || use->env() != v)
+                    return false;
+                size_t n = 0;
+                use->eachArg([&](Value* arg) {
+                    if (arg == v)
+                        n++;
+                });
+                return n == 1;
+            };
+
+            if (MkEnv::Cast(a)) {
+                if ((LdVar::Cast(use) || StVar::Cast(use) ||
+                     IsEnvStub::Cast(use)) &&
+                    onlyAsEnv())
+                    return Escape::OnDeopt;
+                // A child environment or an evaluated promise only keep the
+                // environment alive
+                if (MkEnv::Cast(use) && onlyAsEnv())
+                    return result.at(use);
+                auto mk = MkArg::Cast(use);
+                if (mk && mk->isEager() && onlyAsEnv())
+                    return result.at(use);
+                return Escape::Always;
+            }
+
+            assert(MkArg::Cast(a));
+            if (Force::Cast(use) && use->arg(0).val() == v &&
+                use->env() != v)
+                return Escape::OnDeopt;
+            if (UpdatePromise::Cast(use) && use->arg(0).val() == v &&
+                use->arg(1).val() != v)
+                return Escape::OnDeopt;
+            // Bound in an environment
+            if (MkEnv::Cast(use) && use->env() != v)
+                return result.at(use);
+            return Escape::Always;
+        };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto a : allocations) {
+            auto res = result.at(a);
+            for (auto use : uses.at(a))
+                res = std::max(res, through(a, a, use));
+            if (res != result.at(a)) {
+                result[a] = res;
+                changed = true;
+            }
+        }
+    }
+}
+
+EscapeAnalysis::Escape EscapeAnalysis::at(Instruction* allocation) const {
+    auto r = result.find(allocation);
+    if (r == result.end())
+        return Escape::Always;
+    return r->second;
+}
+
+} // namespace pir
+} // namespace rir
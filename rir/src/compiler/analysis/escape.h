@@ -0,0 +1,33 @@
+#ifndef PIR_ESCAPE_H
+#define PIR_ESCAPE_H
+
+#include "../pir/pir.h"
+
+#include <unordered_map>
+
+namespace rir {
+namespace pir {
+
+/*
+ * Flow-insensitive escape analysis for environments (MkEnv) and promises
+ * (MkArg). An allocation escapes at most on deopt, if it is only accessed by
+ * instructions of this code, which do not store it anywhere else, and by
+ * framestates or deopt branches, which need it to rebuild the interpreter
+ * frames.
+ */
+class EscapeAnalysis {
+  public:
+    enum class Escape : uint8_t { OnDeopt, Always };
+
+    explicit EscapeAnalysis(Code* code);
+
+    Escape at(Instruction* allocation) const;
+
+  private:
+    std::unordered_map<Instruction*, Escape> result;
+};
+
+} // namespace pir
+} // namespace rir
+
+#endif
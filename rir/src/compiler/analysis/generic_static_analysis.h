@@ -11,8 +11,10 @@
 #include "compiler/analysis/cfg.h"
 #include "compiler/log/stream_logger.h"
 
+#include <algorithm>
 #include <stack>
 #include <unordered_map>
+#include <utility>
 
 namespace rir {
 namespace pir {
@@ -88,9 +90,9 @@ class StaticAnalysis {
     std::unordered_map<Instruction*, AbstractState> cache;
     std::deque<Instruction*> cacheQueue;
     void addToCache(Instruction* i, const AbstractState& state) const {
-        if (cache.count(i)) {
-            const_cast<StaticAnalysis*>(this)->cache.erase(cache.find(i));
-            const_cast<StaticAnalysis*>(this)->cache.emplace(i, state);
+        auto cached = const_cast<StaticAnalysis*>(this)->cache.find(i);
+        if (cached != cache.end()) {
+            cached->second = state;
             return;
         }
         if (cacheQueue.size() > MAX_CACHE_SIZE) {
@@ -114,6 +116,37 @@ class StaticAnalysis {
     Code* code;
     std::vector<BB*> entrypoints;
 
+    // The CFG does not change while we compute the fixed-point, thus the
+    // order in which the BBs are visited is computed only once. Forward
+    // analyses use the reverse post-order of the CFG, backward analyses the
+    // post-order. Either way a BB comes after the BBs it gets its state from,
+    // except along back edges.
+    std::vector<BB*> schedule;
+
+    void computeSchedule() {
+        std::vector<bool> seen(code->nextBBId, false);
+        std::vector<std::pair<BB*, size_t>> todo;
+        todo.emplace_back(code->entry, 0);
+        seen[code->entry->id] = true;
+        while (!todo.empty()) {
+            auto bb = todo.back().first;
+            auto next = todo.back().second++;
+            auto successors = bb->successors();
+            if (next < successors.size()) {
+                auto suc = *(successors.begin() + next);
+                if (!seen[suc->id]) {
+                    seen[suc->id] = true;
+                    todo.emplace_back(suc, 0);
+                }
+                continue;
+            }
+            schedule.push_back(bb);
+            todo.pop_back();
+        }
+        if (Forward)
+            std::reverse(schedule.begin(), schedule.end());
+    }
+
   public:
     StaticAnalysis(const std::string& name, ClosureVersion* cls, Code* code,
                    LogStream& log)
@@ -238,8 +271,9 @@ class StaticAnalysis {
 
         BB* bb = i->bb();
 
-        if (cache.count(i)) {
-            auto state = cache.at(i);
+        auto cached = cache.find(i);
+        if (cached != cache.end()) {
+            auto state = cached->second;
             if (PositioningStyle::AfterInstruction == POS)
                 apply(state, i);
             return state;
@@ -326,131 +360,142 @@ class StaticAnalysis {
 
         logHeader();
 
+        if (schedule.empty())
+            computeSchedule();
+
         typedef std::pair<BB*, Instruction*> Position;
         std::vector<Position> recursiveTodo;
         do {
             done = true;
-            for (auto e : entrypoints) {
-                if (globalState)
-                    globalState->resetChanged();
-
-                Visitor::runInDirection(Forward, e, [&](BB* bb) {
-                    size_t id = bb->id;
-
-                    if (!changed[id])
-                        return;
-
-                    AbstractState state = snapshots[id].entry;
-                    logInitialState(state, bb);
-
-                    auto apply = [&](Instruction* i) {
-                        AbstractResult res;
-                        if (DEBUG_LEVEL == AnalysisDebugLevel::Taint) {
-                            AbstractState old = state;
-                            res = compute(state, i);
-                            if (!Deopt::Cast(i)) {
-                                AbstractState old2 = old;
-                                auto changed = old2.merge(state);
-                                if (changed > AbstractResult::None)
-                                    logTaintChange(old, state, res, i);
-                            }
-                        } else {
-                            res = compute(state, i);
-                            logChange(state, res, i);
-                        }
-
-                        auto& snapshot = snapshots[bb->id];
-                        if (res.needRecursion) {
-                            auto& extra = snapshot.extra;
-                            const auto& entry = extra.find(i);
-                            if (entry != extra.end()) {
-                                entry->second.merge(state);
-                                state = entry->second;
-                            } else {
-                                extra.emplace(i, state);
-                            }
-                            recursiveTodo.push_back(Position(bb, i));
+            if (globalState)
+                globalState->resetChanged();
+
+            for (auto bb : schedule) {
+                size_t id = bb->id;
+
+                if (!changed[id])
+                    continue;
+
+                AbstractState state = snapshots[id].entry;
+                logInitialState(state, bb);
+
+                auto apply = [&](Instruction* i) {
+                    AbstractResult res;
+                    if (DEBUG_LEVEL == AnalysisDebugLevel::Taint) {
+                        AbstractState old = state;
+                        res = compute(state, i);
+                        if (!Deopt::Cast(i)) {
+                            AbstractState old2 = old;
+                            auto changed = old2.merge(state);
+                            if (changed > AbstractResult::None)
+                                logTaintChange(old, state, res, i);
                         }
+                    } else {
+                        res = compute(state, i);
+                        logChange(state, res, i);
+                    }
 
-                        if (res.keepSnapshot || snapshot.extra.count(i)) {
-                            snapshot.extra[i] = state;
+                    auto& snapshot = snapshots[bb->id];
+                    if (res.needRecursion) {
+                        auto& extra = snapshot.extra;
+                        const auto& entry = extra.find(i);
+                        if (entry != extra.end()) {
+                            entry->second.merge(state);
+                            state = entry->second;
+                        } else {
+                            extra.emplace(i, state);
                         }
-                    };
-
-                    if (Forward)
-                        for (auto i : *bb)
-                            apply(i);
-                    else
-                        for (auto i : VisitorHelpers::reverse(*bb))
-                            apply(i);
+                        recursiveTodo.push_back(Position(bb, i));
+                    }
 
-                    if (Forward ? bb->isExit() : bb == code->entry) {
-                        logExit(state);
+                    if (res.keepSnapshot ||
+                        (!snapshot.extra.empty() && snapshot.extra.count(i))) {
+                        snapshot.extra[i] = state;
+                    }
+                };
 
-                        auto exitStateIt = exitpoints.find(bb);
-                        if (exitStateIt == exitpoints.end())
-                            exitpoints.emplace(bb, state);
-                        else
-                            exitStateIt->second = state;
+                if (Forward)
+                    for (auto i : *bb)
+                        apply(i);
+                else
+                    for (auto i : VisitorHelpers::reverse(*bb))
+                        apply(i);
 
-                        if (reachedExit) {
-                            exitpoint.mergeExit(state);
-                        } else {
-                            exitpoint = state;
-                            reachedExit = true;
-                        }
+                if (Forward ? bb->isExit() : bb == code->entry) {
+                    logExit(state);
 
-                        changed[id] = false;
-                        return;
+                    if (reachedExit) {
+                        exitpoint.mergeExit(state);
+                    } else {
+                        exitpoint = state;
+                        reachedExit = true;
                     }
 
-                    if (Forward)
-                        for (auto suc : bb->successors())
-                            mergeBranch(bb, suc, state, changed);
+                    auto exitStateIt = exitpoints.find(bb);
+                    if (exitStateIt == exitpoints.end())
+                        exitpoints.emplace(bb, std::move(state));
                     else
-                        for (auto suc : bb->predecessors())
-                            mergeBranch(bb, suc, state, changed);
+                        exitStateIt->second = std::move(state);
 
                     changed[id] = false;
-                });
-                if (!recursiveTodo.empty()) {
-                    for (auto& rec : recursiveTodo) {
-                        auto bb = rec.first->id;
-                        auto& extra = snapshots[bb].extra;
-                        const auto& entry = extra.find(rec.second);
-                        if (entry != extra.end()) {
-                            auto mres = entry->second.mergeExit(exitpoint);
-                            if (mres > AbstractResult::None) {
-                                logChange(entry->second, mres, rec.second);
-                                changed[bb] = true;
-                                done = false;
-                            }
-                        } else {
-                            extra.emplace(rec.second, exitpoint);
+                    continue;
+                }
+
+                // The last successor can take over the state
+                auto mergeAll = [&](const auto& successors) {
+                    size_t n = successors.size();
+                    for (auto suc : successors) {
+                        if (--n)
+                            mergeBranch(bb, suc, state, changed);
+                        else
+                            mergeBranch(bb, suc, std::move(state), changed);
+                    }
+                };
+                if (Forward)
+                    mergeAll(bb->successors());
+                else
+                    mergeAll(bb->predecessors());
+
+                changed[id] = false;
+            }
+            if (!recursiveTodo.empty()) {
+                for (auto& rec : recursiveTodo) {
+                    auto bb = rec.first->id;
+                    auto& extra = snapshots[bb].extra;
+                    const auto& entry = extra.find(rec.second);
+                    if (entry != extra.end()) {
+                        auto mres = entry->second.mergeExit(exitpoint);
+                        if (mres > AbstractResult::None) {
+                            logChange(entry->second, mres, rec.second);
                             changed[bb] = true;
                             done = false;
                         }
+                    } else {
+                        extra.emplace(rec.second, exitpoint);
+                        changed[bb] = true;
+                        done = false;
                     }
-                    recursiveTodo.clear();
                 }
-                if (globalState && globalState->changed())
-                    done = false;
+                recursiveTodo.clear();
             }
+            if (globalState && globalState->changed())
+                done = false;
         } while (!done);
     }
 
-    void mergeBranch(BB* in, BB* branch, const AbstractState& state,
+    template <typename State>
+    void mergeBranch(BB* in, BB* branch, State&& state,
                      std::vector<bool>& changed) {
         auto id = branch->id;
         auto& thisState = snapshots.at(id);
         if (!thisState.seen) {
-            thisState.entry = state;
+            thisState.entry = std::forward<State>(state);
             thisState.seen = true;
             thisState.incomming = in->id;
             done = false;
             changed[id] = true;
         } else if (in->id == thisState.incomming) {
-            thisState.entry = state;
+            thisState.entry = std::forward<State>(state);
             changed[id] = changed[in->id];
         } else {
             thisState.incomming = -1;
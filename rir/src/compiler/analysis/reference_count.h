@@ -292,6 +292,18 @@ class StaticReferenceCount
         case Tag::Extract2_2D:
         case Tag::ColonCastLhs:
         case Tag::ColonCastRhs:
+        // Those only read their arguments, or keep them for deoptimization
+        case Tag::FrameState:
+        case Tag::Checkpoint:
+        case Tag::Assume:
+        case Tag::Branch:
+        case Tag::CheckTrueFalse:
+        case Tag::ChkClosure:
+        case Tag::XLength:
+        case Tag::Names:
+        case Tag::Visible:
+        case Tag::Invisible:
+        case Tag::Nop:
             break;
 
         // Those may override the vector (which is arg 1)
@@ -300,6 +312,7 @@ class StaticReferenceCount
         case Tag::Subassign1_3D:
         case Tag::Subassign2_1D:
         case Tag::Subassign2_2D:
+        case Tag::Append:
             if (auto j = Instruction::Cast(i->arg(1).val()->followCasts())) {
                 if (j->minReferenceCount() < 2) {
                     auto taint = state.isTainted(j);
@@ -1,8 +1,11 @@
 #include "scope.h"
 #include "../pir/pir_impl.h"
 #include "../util/safe_builtins_list.h"
+#include "../util/visitor.h"
 #include "query.h"
 
+#include <unordered_set>
+
 namespace rir {
 namespace pir {
 
@@ -346,11 +349,27 @@ AbstractResult ScopeAnalysis::doCompute(ScopeAnalysisState& state,
                 return;
             }
 
-            if (depth == MAX_DEPTH)
-                return;
-
-            if (version->size() > MAX_SIZE)
+            if (depth == MAX_DEPTH || version->size() > MAX_SIZE) {
+                // We cannot afford to analyze the callee in context, but it
+                // might still leave our environments alone.
+                auto& summary = ScopeAnalysis::summary(version);
+                if (summary.taintsLeaked)
+                    return;
+                bool lazyArgs = false;
+                calli->eachCallArg([&](Value* v) {
+                    lazyArgs = lazyArgs || v->type.maybeLazy();
+                });
+                if (summary.forcesArgs && lazyArgs)
+                    return;
+                if (summary.mayUseReflection && !state.mayUseReflection) {
+                    state.mayUseReflection = true;
+                    effect.lostPrecision();
+                }
+                updateReturnValue(AbstractPirValue::tainted());
+                handled = true;
+                effect.update();
                 return;
+            }
 
             std::vector<Value*> args;
             calli->eachCallArg([&](Value* v) { args.push_back(v); });
@@ -513,6 +532,111 @@ AbstractResult ScopeAnalysis::doCompute(ScopeAnalysisState& state,
     return effect;
 }
 
+// Environments created by the version itself, the caller cannot refer to them
+static bool isLocalEnv(Value* env) {
+    return env == Env::elided() || MkEnv::Cast(env) ||
+           LdFunctionEnv::Cast(env) || MaterializeEnv::Cast(env);
+}
+
+// Revisions are never reused, thus stale entries are only wasting space
+static std::unordered_map<size_t, ScopeSummary> summaries;
+
+static const ScopeSummary&
+computeSummary(ClosureVersion* version,
+               std::unordered_set<ClosureVersion*>& inProgress) {
+    auto cached = summaries.find(version->revision());
+    if (cached != summaries.end())
+        return cached->second;
+
+    ScopeSummary summary;
+    inProgress.insert(version);
+
+    // Forcing a lazy value only runs code we do not see, if it is one of our
+    // arguments, or we loaded it from somewhere.
+    auto forces = [&](Value* v) {
+        v = v->followCastsAndForce();
+        if (!v->type.maybeLazy() || MkArg::Cast(v))
+            return;
+        if (LdArg::Cast(v))
+            summary.forcesArgs = true;
+        else
+            summary.taintsLeaked = true;
+    };
+
+    auto scan = [&](Code* code) {
+        Visitor::run(code->entry, [&](Instruction* i) {
+            // The interpreter continues a deopt, like in the in-context
+            // analysis it can run anything and reach any leaked environment.
+            if (Deopt::Cast(i)) {
+                summary.mayUseReflection = true;
+                summary.taintsLeaked = true;
+                return;
+            }
+            if (i->effects.contains(Effect::Reflection))
+                summary.mayUseReflection = true;
+
+            if (auto force = Force::Cast(i)) {
+                forces(force->arg<0>().val());
+                return;
+            }
+            if (CallSafeBuiltin::Cast(i))
+                return;
+            if (auto builtin = CallBuiltin::Cast(i)) {
+                if (!SafeBuiltinsList::nonObject(builtin->builtinSexp))
+                    summary.taintsLeaked = true;
+                builtin->eachCallArg([&](Value* v) {
+                    if (v->type.maybeObj())
+                        summary.taintsLeaked = true;
+                });
+                return;
+            }
+            if (auto call = StaticCall::Cast(i)) {
+                auto target = call->tryDispatch();
+                if (!target || inProgress.count(target)) {
+                    summary.taintsLeaked = true;
+                    return;
+                }
+                auto& callee = computeSummary(target, inProgress);
+                if (callee.taintsLeaked)
+                    summary.taintsLeaked = true;
+                if (callee.mayUseReflection)
+                    summary.mayUseReflection = true;
+                if (callee.forcesArgs)
+                    call->eachCallArg(forces);
+                return;
+            }
+            if (CallInstruction::CastCall(i) || StVarSuper::Cast(i)) {
+                summary.taintsLeaked = true;
+                return;
+            }
+
+            bool noObjects =
+                i->hasEnv() && i->envOnlyForObj() &&
+                !i->anyArg([&](Value* v) {
+                    return v != i->env() && v->type.maybeObj();
+                });
+            if (!noObjects && (i->effects.contains(Effect::ExecuteCode) ||
+                               i->effects.contains(Effect::Force)))
+                summary.taintsLeaked = true;
+            if (i->hasEnv() && !isLocalEnv(i->env()) &&
+                (i->changesEnv() || i->leaksEnv()))
+                summary.taintsLeaked = true;
+        });
+    };
+    scan(version);
+    version->eachPromise([&](Promise* p) { scan(p); });
+
+    inProgress.erase(version);
+    return summaries[version->revision()] = summary;
+}
+
+const ScopeSummary& ScopeAnalysis::summary(ClosureVersion* version) {
+    if (summaries.size() > MAX_RESULTS)
+        summaries.clear();
+    std::unordered_set<ClosureVersion*> inProgress;
+    return computeSummary(version, inProgress);
+}
+
 void ScopeAnalysis::tryMaterializeEnv(const ScopeAnalysisState& state,
                                       Value* env,
                                       const MaybeMaterialized& action) {
@@ -28,6 +28,19 @@ struct ScopeAnalysisResults {
     bool changed() const { return _changed; }
 };
 
+/*
+ * Context independent summary of what a call to a closure version can do to
+ * the environments of its caller. Used instead of analyzing the callee in
+ * context, once the depth or size limits are reached.
+ */
+struct ScopeSummary {
+    // The callee might change leaked environments of the caller
+    bool taintsLeaked = false;
+    // The callee might force its arguments
+    bool forcesArgs = false;
+    bool mayUseReflection = false;
+};
+
 class ScopeAnalysisState {
     AbstractREnvironmentHierarchy envs;
     AbstractPirValue returnValue;
@@ -215,6 +228,9 @@ class ScopeAnalysis
         return aLoad;
     }
 
+    // Computed once per revision of the version
+    static const ScopeSummary& summary(ClosureVersion*);
+
     typedef std::function<void(
         const std::unordered_map<SEXP, std::pair<AbstractPirValue, bool>>&)>
         MaybeMaterialized;
@@ -1,12 +1,15 @@
 #include "backend.h"
 #include "R/BuiltinIds.h"
 #include "analysis/dead.h"
+#include "compiler/analysis/abstract_value.h"
 #include "compiler/analysis/cfg.h"
+#include "compiler/analysis/generic_static_analysis.h"
 #include "compiler/analysis/last_env.h"
 #include "compiler/analysis/reference_count.h"
 #include "compiler/analysis/verifier.h"
 #include "compiler/log/perf_counter.h"
 #include "compiler/native/lower_llvm.h"
+#include "compiler/native/representation_llvm.h"
 #include "compiler/parameter.h"
 #include "compiler/pir/pir_impl.h"
 #include "compiler/pir/value_list.h"
@@ -46,6 +49,7 @@ static void approximateNeedsLdVarForUpdate(
         case Tag::Subassign2_1D:
         case Tag::Subassign1_2D:
         case Tag::Subassign2_2D:
+        case Tag::Append:
             // Subassigns override the vector, even if the named count
             // is 1. This is only valid, if we are sure that the vector
             // is local, ie. vector and subassign operation come from
@@ -244,6 +248,144 @@ static void lower(Code* code) {
     });
 }
 
+// Values unboxed by a type cast are re-boxed by the native backend when they
+// are stored into an environment, returned or passed to a phi with SEXP
+// representation. If the boxed input of the cast is still available and
+// cannot have been modified in-place, we use the original box instead of
+// allocating a new one. Boxes which are only needed on deopt paths are already
+// allocated lazily by the native backend.
+struct ABox {
+    CastType* cast;
+    Value* box;
+
+    bool operator==(const ABox& other) const {
+        return cast == other.cast && box == other.box;
+    }
+    void print(std::ostream& out, bool) {
+        cast->printRef(out);
+        out << "@";
+        box->printRef(out);
+    }
+};
+
+struct AvailableBoxes : public StaticAnalysis<IntersectionSet<ABox>> {
+    AvailableBoxes(ClosureVersion* cls, Code* code, LogStream& log)
+        : StaticAnalysis("AvailableBoxes", cls, code, log) {}
+
+    AbstractResult apply(IntersectionSet<ABox>& state,
+                         Instruction* i) const override {
+        static const Effects mayModifyBox = Effects(Effect::ExecuteCode) |
+                                            Effect::Force | Effect::Reflection |
+                                            Effect::MutatesArgument;
+        AbstractResult res;
+        if (i->effects.intersects(mayModifyBox)) {
+            if (!state.available.empty()) {
+                state.available.clear();
+                res.update();
+            }
+            return res;
+        }
+
+        switch (i->tag) {
+        case Tag::StVar:
+        case Tag::StVarSuper:
+        case Tag::MkEnv:
+        case Tag::Return:
+        case Tag::CastType:
+        case Tag::IsType:
+        case Tag::Assume:
+            break;
+        default:
+            // Any other use of the box, or of a boxed alias, might update it
+            // in-place
+            i->eachArg([&](Value* v) {
+                if (Representation::Of(v) != Representation::Sexp)
+                    return;
+                for (auto b = state.available.begin();
+                     b != state.available.end();) {
+                    if (b->box->followCasts() == v->followCasts()) {
+                        b = state.available.erase(b);
+                        res.update();
+                    } else {
+                        b++;
+                    }
+                }
+            });
+        }
+
+        if (auto cast = CastType::Cast(i)) {
+            auto in = cast->arg(0).val();
+            if (cast->kind == CastType::Downcast &&
+                Representation::Of(cast) != Representation::Sexp &&
+                Representation::Of(in) == Representation::Sexp) {
+                state.available.insert({cast, in});
+                res.update();
+            }
+        }
+        return res;
+    }
+
+    bool available(CastType* cast, Instruction* pos, bool after) const {
+        auto state =
+            after ? at<PositioningStyle::AfterInstruction>(pos)
+                  : at<PositioningStyle::BeforeInstruction>(pos);
+        return state.available.includes({cast, cast->arg(0).val()});
+    }
+};
+
+static void reuseBoxes(ClosureVersion* cls, Code* code,
+                       ClosureStreamLogger& log) {
+    AvailableBoxes boxes(cls, code, log.out());
+    struct Reuse {
+        InstrArg* arg;
+        CastType* cast;
+        PirType type;
+    };
+    std::vector<Reuse> reuse;
+
+    Visitor::run(code->entry, [&](Instruction* i) {
+        switch (i->tag) {
+        case Tag::StVar:
+        case Tag::StVarSuper:
+        case Tag::MkEnv:
+        case Tag::Return:
+            i->eachArg([&](InstrArg& arg) {
+                auto cast = CastType::Cast(arg.val());
+                if (cast && boxes.available(cast, i, false))
+                    reuse.push_back({&arg, cast, cast->type.orNotScalar()});
+            });
+            break;
+        case Tag::Phi: {
+            // The phi holds the box afterwards, thus it must not have any
+            // uses which could modify it in-place
+            auto phi = Phi::Cast(i);
+            if (Representation::Of(phi) != Representation::Sexp ||
+                !phi->usesAreOnly(code->entry,
+                                  {Tag::StVar, Tag::StVarSuper, Tag::MkEnv,
+                                   Tag::Return}))
+                break;
+            phi->eachArg([&](BB* pred, InstrArg& arg) {
+                auto cast = CastType::Cast(arg.val());
+                if (cast && boxes.available(cast, pred->last(), true))
+                    reuse.push_back({&arg, cast, phi->type});
+            });
+            break;
+        }
+        default:
+            break;
+        }
+    });
+
+    // The box might have a wider type than the use expects, e.g. if it was
+    // loaded from an environment. The downcast keeps the SEXP representation.
+    for (auto& r : reuse) {
+        auto in = r.cast->arg(0).val();
+        auto box = new CastType(in, CastType::Downcast, in->type, r.type);
+        r.cast->bb()->insert(r.cast->bb()->atPosition(r.cast) + 1, box);
+        r.arg->val() = box;
+    }
+}
+
 static void toCSSA(Code* code) {
 
     // For each Phi, insert copies
@@ -289,6 +431,32 @@ static void toCSSA(Code* code) {
     });
 }
 
+// A version needs a context unless it cannot observe it and nothing can
+// longjmp to it. Errors, warnings, deopts, calls, promise forcing and
+// environment creation (which updates the cloenv of the current context)
+// all require one.
+static bool needsContext(ClosureVersion* cls) {
+    if (!cls->properties.includes(ClosureVersion::Property::NoReflection))
+        return true;
+    static Effects contextEffects =
+        Effects(Effect::Error) | Effect::Warn | Effect::Force |
+        Effect::Reflection | Effect::ExecuteCode | Effect::TriggerDeopt |
+        Effect::ChangesContexts | Effect::LeaksEnv;
+    return !Visitor::check(cls->entry, [&](Instruction* i) -> bool {
+        switch (i->tag) {
+        case Tag::MkEnv:
+        case Tag::Deopt:
+        case Tag::Checkpoint:
+        case Tag::Assume:
+        case Tag::NonLocalReturn:
+        case Tag::PushContext:
+            return false;
+        default:
+            return !i->effects.intersects(contextEffects);
+        }
+    });
+}
+
 rir::Function* Backend::doCompile(ClosureVersion* cls,
                                   ClosureStreamLogger& log) {
     // TODO: keep track of source ast indices in the source pool
@@ -329,6 +497,7 @@ rir::Function* Backend::doCompile(ClosureVersion* cls,
             }
         };
         lower(c);
+        reuseBoxes(cls, c, log);
         toCSSA(c);
         log.CSSA(c);
 #ifdef FULLVERIFIER
@@ -369,6 +538,8 @@ rir::Function* Backend::doCompile(ClosureVersion* cls,
         return res;
     };
     auto body = compile(cls);
+    if (!needsContext(cls))
+        body->flags.set(rir::Code::NoContext);
 
     log.finalPIR(cls);
     function.finalize(body, signature, cls->context());
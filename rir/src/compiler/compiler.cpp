@@ -9,6 +9,8 @@
 #include "compiler/opt/pass_definitions.h"
 #include "compiler/opt/pass_scheduler.h"
 #include "compiler/parameter.h"
+#include "compiler/util/translation_cache.h"
+#include "runtime_stats.h"
 
 #include "ir/BC.h"
 #include "ir/Compiler.h"
@@ -69,6 +71,53 @@ void Compiler::compileFunction(rir::DispatchTable* src, const std::string& name,
                    outerFeedback);
 }
 
+void Compiler::compileContinuation(SEXP closure, const std::string& name,
+                                   Opcode* pc,
+                                   const std::vector<PirType>& stack,
+                                   MaybeCls success, Maybe fail) {
+    assert(isValidClosureSEXP(closure));
+
+    DispatchTable* tbl = DispatchTable::unpack(BODY(closure));
+    auto fun = tbl->baseline();
+    if (fun->body()->codeSize > Parameter::MAX_INPUT_SIZE) {
+        RuntimeStats::count(RuntimeStats::FailedHugeFunction);
+        return fail();
+    }
+
+    // Continuations are not registered with the rir closure, thus they can
+    // never be the target of a call.
+    static SEXP srcRefSymbol = Rf_install("srcref");
+    auto pirClosure = module->getOrDeclareRirFunction(
+        name, fun, FORMALS(closure), Rf_getAttrib(closure, srcRefSymbol),
+        tbl->userDefinedContext());
+    // The arguments are the rir stack, not the formals, so the version does
+    // not assume anything about them
+    Context context;
+    auto version = pirClosure->declareVersion(context, nullptr);
+    Builder builder(version);
+    auto& log = logger.begin(version);
+    Rir2Pir rir2pir(*this, version, log, name, {});
+
+    // We do not see which variables the frame already holds
+    seenC = true;
+
+    if (rir2pir.tryCompileContinuation(builder, pc, stack)) {
+        log.compilationEarlyPir(version);
+#ifndef NDEBUG
+        Verify::apply(version, "Error after initial translation");
+#endif
+        log.flush();
+        return success(version);
+    }
+
+    log.failed("rir2pir aborted");
+    log.flush();
+    logger.close(version);
+    pirClosure->erase(context);
+    RuntimeStats::count(RuntimeStats::FailedRir2Pir);
+    return fail();
+}
+
 void Compiler::compileClosure(Closure* closure, rir::Function* optFunction,
                               const Context& ctx, MaybeCls success, Maybe fail,
                               std::list<PirTypeFeedback*> outerFeedback) {
@@ -79,6 +128,7 @@ void Compiler::compileClosure(Closure* closure, rir::Function* optFunction,
                 std::stringstream as;
                 as << "Missing minimal assumption " << a;
                 logger.warn(as.str());
+                RuntimeStats::count(RuntimeStats::FailedMinimalContext);
                 return fail();
             }
         }
@@ -92,18 +142,33 @@ void Compiler::compileClosure(Closure* closure, rir::Function* optFunction,
     if (!ctx.includes(Assumption::StaticallyArgmatched) &&
         closure->formals().hasDots()) {
         logger.warn("no support for ...");
+        RuntimeStats::count(RuntimeStats::FailedDots);
         return fail();
     }
 
     if (closure->rirFunction()->body()->codeSize > Parameter::MAX_INPUT_SIZE) {
         closure->rirFunction()->flags.set(Function::NotOptimizable);
         logger.warn("skipping huge function");
+        RuntimeStats::count(RuntimeStats::FailedHugeFunction);
         return fail();
     }
 
     if (auto existing = closure->findCompatibleVersion(ctx))
         return success(existing);
 
+    // The translation depends on the outer feedback and on whether `c` might
+    // have been redefined, such versions are not shared between compilations.
+    bool cacheable = outerFeedback.empty() && !seenC;
+    if (cacheable) {
+        if (auto cached =
+                TranslationCache::get(closure, ctx, optFunction, module)) {
+            auto& log = logger.begin(cached);
+            log.compilationEarlyPir(cached);
+            log.flush();
+            return success(cached);
+        }
+    }
+
     auto version = closure->declareVersion(ctx, optFunction);
     Builder builder(version, closure->closureEnv());
     auto& log = logger.begin(version);
@@ -120,7 +185,7 @@ void Compiler::compileClosure(Closure* closure, rir::Function* optFunction,
 
         auto arg = closure->formals().defaultArgs()[idx];
         assert(rir::Code::check(arg) && "Default arg not compiled");
-        auto code = rir::Code::unpack(arg);
+        auto code = rir::Code::unpack(arg)->materialized();
         auto res = rir2pir.tryCreateArg(code, builder, false);
         if (!res) {
             failedToCompileDefaultArgs = true;
@@ -179,6 +244,7 @@ void Compiler::compileClosure(Closure* closure, rir::Function* optFunction,
         logger.warn("Failed to compile default arg");
         logger.close(version);
         closure->erase(ctx);
+        RuntimeStats::count(RuntimeStats::FailedDefaultArg);
         return fail();
     }
 
@@ -191,6 +257,8 @@ void Compiler::compileClosure(Closure* closure, rir::Function* optFunction,
         Verify::apply(version, "Error after initial translation");
 #endif
 #endif
+        if (cacheable && !seenC)
+            TranslationCache::put(version);
         log.flush();
         return success(version);
     }
@@ -199,6 +267,7 @@ void Compiler::compileClosure(Closure* closure, rir::Function* optFunction,
     log.flush();
     logger.close(version);
     closure->erase(ctx);
+    RuntimeStats::count(RuntimeStats::FailedRir2Pir);
     return fail();
 }
 
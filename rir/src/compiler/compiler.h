@@ -4,10 +4,12 @@
 #include "R/Preserve.h"
 #include "log/stream_logger.h"
 #include "pir/pir.h"
+#include "ir/BC_inc.h"
 #include "utils/FormalArgs.h"
 
 #include <list>
 #include <stack>
+#include <vector>
 
 namespace rir {
 struct DispatchTable;
@@ -36,6 +38,11 @@ class Compiler {
                          SEXP formals, SEXP srcRef, const Context& ctx,
                          MaybeCls success, Maybe fail,
                          std::list<PirTypeFeedback*> outerFeedback);
+    // Optimized code for the rest of an evaluation of the closure, which
+    // resumes at pc with the given types on the rir stack (see Deoptless)
+    void compileContinuation(SEXP closure, const std::string& name,
+                             Opcode* pc, const std::vector<PirType>& stack,
+                             MaybeCls success, Maybe fail);
     void optimizeModule();
 
     bool seenC = false;
@@ -0,0 +1,234 @@
+#include "deoptless.h"
+
+#include "api.h"
+#include "compiler/backend.h"
+#include "compiler/compiler.h"
+#include "compiler/parameter.h"
+#include "compiler/pir/pir_impl.h"
+#include "interpreter/call_context.h"
+#include "interpreter/instance.h"
+#include "interpreter/interp.h"
+#include "interpreter/sampling_profiler.h"
+#include "ir/BC.h"
+#include "ir/Deoptimization.h"
+#include "runtime/DispatchTable.h"
+#include "runtime/LazyEnvironment.h"
+#include "runtime_stats.h"
+
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+namespace rir {
+namespace pir {
+
+bool Parameter::DEOPTLESS =
+    !getenv("PIR_DEOPTLESS") || 0 != strncmp("0", getenv("PIR_DEOPTLESS"), 1);
+unsigned Parameter::DEOPTLESS_MAX_VERSIONS =
+    getenv("PIR_DEOPTLESS_MAX_VERSIONS")
+        ? atoi(getenv("PIR_DEOPTLESS_MAX_VERSIONS"))
+        : 4;
+
+struct Continuation {
+    std::vector<PirType> stack;
+    // nullptr if the compilation failed
+    rir::Function* fun;
+};
+
+struct SiteContinuations {
+    // Includes failed and dropped versions
+    unsigned compiled = 0;
+    std::vector<Continuation> versions;
+};
+
+// The continuations of a closure hang off its dispatch table, in an external
+// pointer whose protected list keeps the compiled functions alive. A guard is
+// identified by the pc in the baseline code it resumes, the tag of the pointer
+// keeps that code alive.
+struct Continuations {
+    std::unordered_map<Opcode*, SiteContinuations> sites;
+};
+
+static void dropContinuations(SEXP ptr) {
+    delete static_cast<Continuations*>(R_ExternalPtrAddr(ptr));
+    R_ClearExternalPtr(ptr);
+}
+
+static Continuations* continuationsOf(DispatchTable* table) {
+    auto baseline = table->baseline()->body()->container();
+    SEXP ptr = table->continuations();
+    if (!ptr) {
+        ptr = R_MakeExternalPtr(new Continuations, baseline, R_NilValue);
+        PROTECT(ptr);
+        R_RegisterCFinalizerEx(ptr, &dropContinuations, FALSE);
+        table->continuations(ptr);
+        UNPROTECT(1);
+    }
+    auto res = static_cast<Continuations*>(R_ExternalPtrAddr(ptr));
+    // The sites refer to the old baseline code
+    if (R_ExternalPtrTag(ptr) != baseline) {
+        res->sites.clear();
+        R_SetExternalPtrTag(ptr, baseline);
+        R_SetExternalPtrProtected(ptr, R_NilValue);
+    }
+    return res;
+}
+
+static void keepAlive(DispatchTable* table, rir::Function* fun) {
+    SEXP ptr = table->continuations();
+    R_SetExternalPtrProtected(
+        ptr, CONS(fun->container(), R_ExternalPtrProtected(ptr)));
+}
+
+static void release(DispatchTable* table, rir::Function* fun) {
+    SEXP ptr = table->continuations();
+    SEXP prev = nullptr;
+    for (SEXP l = R_ExternalPtrProtected(ptr); l != R_NilValue; l = CDR(l)) {
+        if (CAR(l) == fun->container()) {
+            if (prev)
+                SETCDR(prev, CDR(l));
+            else
+                R_SetExternalPtrProtected(ptr, CDR(l));
+            return;
+        }
+        prev = l;
+    }
+}
+
+// Frames outside of loops end soon anyway, they do not pay for a compilation
+static bool inLoop(rir::Code* code, Opcode* pc) {
+    for (auto pos = code->code(); pos != code->endCode(); pos = BC::next(pos)) {
+        BC bc = BC::decodeShallow(pos);
+        if (bc.isJmp() && bc.jmpTarget(pos) <= pc && pc <= pos)
+            return true;
+    }
+    return false;
+}
+
+static rir::Function* compile(SEXP closure, Opcode* pc,
+                              const std::vector<PirType>& stack) {
+    auto body = DispatchTable::unpack(BODY(closure))->baseline()->body();
+    std::stringstream name;
+    name << "continuation@" << (pc - body->code());
+
+    rir::Function* res = nullptr;
+    Module* m = new Module;
+    StreamLogger logger(PirDebug);
+    logger.title("Compiling " + name.str());
+    Compiler cmp(m, logger);
+    Backend backend(logger);
+    cmp.compileContinuation(closure, name.str(), pc, stack,
+                            [&](ClosureVersion* c) {
+                                logger.flush();
+                                cmp.optimizeModule();
+                                res = backend.compile(c);
+                                RuntimeStats::count(
+                                    RuntimeStats::DeoptlessCompilations);
+                            },
+                            [&]() {
+                                RuntimeStats::count(
+                                    RuntimeStats::CompileFailures);
+                            });
+    delete m;
+    return res;
+}
+
+bool Deoptless::dropContinuation(rir::Code* c, SEXP closure) {
+    if (!closure)
+        return false;
+    auto table = DispatchTable::unpack(BODY(closure));
+    if (!table->continuations())
+        return false;
+    // The next continuation for the site is compiled with the feedback of
+    // this deopt
+    for (auto& site : continuationsOf(table)->sites) {
+        auto& versions = site.second.versions;
+        for (auto v = versions.begin(); v != versions.end(); ++v) {
+            if (v->fun && v->fun->body() == c) {
+                release(table, v->fun);
+                versions.erase(v);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Deoptless::continueFrame(rir::Code* c, SEXP closure, DeoptMetadata* m) {
+    // Chaos deopts are meant to exercise the interpreter fallback
+    if (!Parameter::DEOPTLESS || Parameter::DEOPT_CHAOS || !closure ||
+        m->numFrames != 1)
+        return;
+    auto& frame = m->frames[0];
+    auto table = DispatchTable::unpack(BODY(closure));
+    auto body = table->baseline()->body();
+    if (frame.inPromise || frame.code != body || !inLoop(body, frame.pc))
+        return;
+
+    auto ctx = globalContext();
+    SEXP env = ostack_at(ctx, 0);
+    if (auto le = LazyEnvironment::check(env)) {
+        if (le->materialized())
+            env = le->materialized();
+    }
+    auto cntxt = findFunctionContextFor(env);
+    if (!cntxt)
+        return;
+
+    // The stack values are the arguments of the continuation
+    R_bcstack_t* args = ostack_cell_at(ctx, frame.stackSize);
+    std::vector<PirType> types;
+    for (size_t i = 0; i < frame.stackSize; ++i)
+        types.emplace_back(ostack_at_cell(args + i));
+
+    auto& site = continuationsOf(table)->sites[frame.pc];
+    auto version = std::find_if(
+        site.versions.begin(), site.versions.end(),
+        [&](const Continuation& v) { return v.stack == types; });
+    rir::Function* fun;
+    if (version != site.versions.end()) {
+        fun = version->fun;
+        // A deopt without the closure only disabled the native code
+        if (fun && !fun->body()->nativeCode) {
+            release(table, fun);
+            site.versions.erase(version);
+            return;
+        }
+    } else {
+        if (site.compiled >= Parameter::DEOPTLESS_MAX_VERSIONS)
+            return;
+        site.compiled++;
+        fun = compile(closure, frame.pc, types);
+        if (fun)
+            keepAlive(table, fun);
+        site.versions.push_back({types, fun});
+    }
+    if (!fun)
+        return;
+
+    if (auto le = LazyEnvironment::check(env)) {
+        assert(!le->materialized());
+        env = materialize(env);
+        cntxt->cloenv = env;
+        ostack_set(ctx, 0, env);
+    }
+
+    RuntimeStats::count(RuntimeStats::DeoptlessContinuations);
+    auto code = fun->body();
+    SEXP res;
+    {
+        // Like a deopt, the continuation is a frame of its own in profiles
+        CallContext call(ArglistOrder::NOT_REORDERED, code, closure,
+                         /* nargs */ -1, cntxt->call, args,
+                         (Immediate*)nullptr, env, Context(), ctx);
+        SamplingProfiler::Frame profilerFrame(code, &call, true, false);
+        res = code->nativeCode(code, args, env, closure);
+    }
+    assert(findFunctionContextFor(env) == cntxt);
+    Rf_findcontext(CTXT_BROWSER | CTXT_FUNCTION, env, res);
+    assert(false);
+}
+
+} // namespace pir
+} // namespace rir
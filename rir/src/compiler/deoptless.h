@@ -0,0 +1,43 @@
+#ifndef PIR_DEOPTLESS_H
+#define PIR_DEOPTLESS_H
+
+#include "R/r.h"
+
+namespace rir {
+struct Code;
+struct DeoptMetadata;
+
+namespace pir {
+
+/*
+ * Deopt-less continuations.
+ *
+ * A failing guard normally rebuilds the frames of the optimized code and
+ * continues in the interpreter, until the function is called again and
+ * recompiled. In a long running loop that means the rest of the loop is
+ * interpreted. Instead, the frame can be resumed in an optimized
+ * continuation: the body compiled from the pc of the deopt onwards, with the
+ * values on the rir stack as arguments and the (materialized) environment of
+ * the frame. It is compiled with the feedback which caused the deopt and
+ * specialized to the types of the stack values, and cached per guard and
+ * types.
+ *
+ * Only frames in a loop of the function body are continued, deopts of
+ * inlined frames and of continuations themselves go through the interpreter.
+ * The continuations live as long as the dispatch table of the closure.
+ */
+class Deoptless {
+  public:
+    // If c is a continuation of closure, it is forgotten and true returned.
+    // Nothing refers to it afterwards, except for the running deopt.
+    static bool dropContinuation(rir::Code* c, SEXP closure);
+
+    // Continues the outermost frame of the deopt in optimized code, and
+    // returns from its function. Returns if there is no continuation for it.
+    static void continueFrame(rir::Code* c, SEXP closure, DeoptMetadata* m);
+};
+
+} // namespace pir
+} // namespace rir
+
+#endif
@@ -1,12 +1,16 @@
 #include "builtins.h"
 
+#include "compiler/deoptless.h"
 #include "compiler/parameter.h"
 #include "interpreter/cache.h"
 #include "interpreter/call_context.h"
 #include "interpreter/interp.h"
+#include "interpreter/sampling_profiler.h"
 #include "ir/Deoptimization.h"
+#include "runtime/FeedbackWindow.h"
 #include "runtime/LazyArglist.h"
 #include "runtime/LazyEnvironment.h"
+#include "runtime_stats.h"
 #include "utils/Pool.h"
 
 #include "R/Funtab.h"
@@ -166,7 +170,7 @@ SEXP ldvarCachedImpl(SEXP sym, SEXP env, SEXP* cache) {
         } else {
             *cache = loc.cell;
             if (CAR(*cache) != R_UnboundValue) {
-                ENSURE_NAMED(*cache);
+                ENSURE_NAMED(CAR(*cache));
                 return CAR(*cache);
             }
         }
@@ -181,6 +185,29 @@ NativeBuiltin NativeBuiltins::ldvarCacheMiss = {
     (void*)&ldvarCachedImpl,
 };
 
+// Like ldvarCached, but the value will be updated in-place. Only values
+// from an enclosing environment have to be marked shared, see ldvarForUpdate.
+SEXP ldvarForUpdateCachedImpl(SEXP sym, SEXP env, SEXP* cache) {
+    if (*cache != (SEXP)NativeBuiltins::bindingsCacheFails) {
+        R_varloc_t loc = R_findVarLocInFrame(env, sym);
+        if (R_VARLOC_IS_NULL(loc)) {
+            *cache = (SEXP)(((uintptr_t)*cache) + 1);
+        } else {
+            *cache = loc.cell;
+            if (CAR(*cache) != R_UnboundValue) {
+                ENSURE_NAMED(CAR(*cache));
+                return CAR(*cache);
+            }
+        }
+    }
+    return ldvarForUpdateImpl(sym, env);
+}
+
+NativeBuiltin NativeBuiltins::ldvarForUpdateCacheMiss = {
+    "ldvarForUpdateCacheMiss",
+    (void*)&ldvarForUpdateCachedImpl,
+};
+
 void stvarSuperImpl(SEXP a, SEXP val, SEXP env) {
     auto le = LazyEnvironment::check(env);
     assert(!le || !le->materialized());
@@ -373,11 +400,53 @@ NativeBuiltin NativeBuiltins::callBuiltin = {
     (void*)&callBuiltinImpl,
 };
 
+// Native call sites bind to one version of their callee. The binding is
+// kept in a constant pool slot and records the dispatch table of the callee,
+// the version and the table version at the time of binding. Adding or
+// removing a version (which includes marking it Dead) bumps the table
+// version and thereby invalidates all bindings to that table.
+enum CallSiteBinding { BoundTable, BoundTarget, BoundTableVersion, BindingSize };
+
+void bindCallSite(Immediate site, SEXP callee, Function* fun) {
+    auto dt = DispatchTable::unpack(BODY(callee));
+    SEXP binding = Rf_allocVector(VECSXP, BindingSize);
+    PROTECT(binding);
+    SET_VECTOR_ELT(binding, BoundTable, dt->container());
+    SET_VECTOR_ELT(binding, BoundTarget, fun->container());
+    SET_VECTOR_ELT(binding, BoundTableVersion,
+                   Rf_ScalarInteger((int)dt->version()));
+    // Not Pool::patch, the binding is replaced over time and must not stay
+    // in the pool's index of constants.
+    cp_pool_set(globalContext(), site, binding);
+    UNPROTECT(1);
+}
+
+static Function* boundCallTarget(Immediate site, SEXP callee) {
+    auto binding = Pool::get(site);
+    if (TYPEOF(binding) != VECSXP || TYPEOF(callee) != CLOSXP ||
+        BODY(callee) != VECTOR_ELT(binding, BoundTable))
+        return nullptr;
+    auto dt = DispatchTable::unpack(BODY(callee));
+    if (INTEGER(VECTOR_ELT(binding, BoundTableVersion))[0] !=
+        (int)dt->version())
+        return nullptr;
+    return Function::unpack(VECTOR_ELT(binding, BoundTarget));
+}
+
 static SEXP callImplCached(CallContext& call, Immediate cache) {
     auto res = doCall(call, globalContext());
-    if (cache != 0) {
+    if (cache != 0 && TYPEOF(call.callee) == CLOSXP &&
+        DispatchTable::check(BODY(call.callee))) {
         auto trg = dispatch(call, DispatchTable::unpack(BODY(call.callee)));
-        Pool::patch(cache, trg->container());
+        // Only versions with the native calling convention can be called
+        // directly, everything else goes through doCall anyway.
+        if (trg->body()->nativeCode &&
+            trg->signature().envCreation ==
+                FunctionSignature::Environment::CalleeCreated) {
+            PROTECT(res);
+            bindCallSite(cache, call.callee, trg);
+            UNPROTECT(1);
+        }
     }
     ostack_popn(ctx, call.passedArgs - call.suppliedArgs);
     return res;
@@ -463,6 +532,7 @@ NativeBuiltin NativeBuiltins::dotsCall = {
 };
 
 SEXP createPromiseImpl(SEXP expr, SEXP env) {
+    RuntimeStats::count(RuntimeStats::PromiseAllocations);
     SEXP res = Rf_mkPROMISE(expr, env);
     SET_PRVALUE(res, R_UnboundValue);
     return res;
@@ -475,6 +545,7 @@ NativeBuiltin NativeBuiltins::createPromise = {
 
 SEXP createPromiseNoEnvEagerImpl(SEXP exp, SEXP value) {
     SLOWASSERT(TYPEOF(value) != PROMSXP);
+    RuntimeStats::count(RuntimeStats::PromiseAllocations);
     SEXP res = Rf_mkPROMISE(exp, R_EmptyEnv);
     ENSURE_NAMEDMAX(value);
     SET_PRVALUE(res, value);
@@ -486,7 +557,10 @@ NativeBuiltin NativeBuiltins::createPromiseNoEnvEager = {
     (void*)&createPromiseNoEnvEagerImpl,
 };
 
-SEXP createPromiseNoEnvImpl(SEXP exp) { return Rf_mkPROMISE(exp, R_EmptyEnv); }
+SEXP createPromiseNoEnvImpl(SEXP exp) {
+    RuntimeStats::count(RuntimeStats::PromiseAllocations);
+    return Rf_mkPROMISE(exp, R_EmptyEnv);
+}
 
 NativeBuiltin NativeBuiltins::createPromiseNoEnv = {
     "createPromiseNoEnv",
@@ -495,6 +569,7 @@ NativeBuiltin NativeBuiltins::createPromiseNoEnv = {
 
 SEXP createPromiseEagerImpl(SEXP exp, SEXP env, SEXP value) {
     SLOWASSERT(TYPEOF(value) != PROMSXP);
+    RuntimeStats::count(RuntimeStats::PromiseAllocations);
     SEXP res = Rf_mkPROMISE(exp, env);
     ENSURE_NAMEDMAX(value);
     SET_PRVALUE(res, value);
@@ -520,7 +595,10 @@ NativeBuiltin NativeBuiltins::createClosure = {
     (void*)&createClosureImpl,
 };
 
-SEXP newIntImpl(int i) { return ScalarInteger(i); }
+SEXP newIntImpl(int i) {
+    RuntimeStats::count(RuntimeStats::NativeBoxes);
+    return ScalarInteger(i);
+}
 
 SEXP newIntDebugImpl(int i, void* debug) {
     std::cout << (char*)debug << "\n";
@@ -530,11 +608,18 @@ SEXP newIntDebugImpl(int i, void* debug) {
 }
 
 SEXP newIntFromRealImpl(double d) {
+    RuntimeStats::count(RuntimeStats::NativeBoxes);
     return ScalarInteger(d != d ? NA_INTEGER : d);
 }
 
-SEXP newRealImpl(double i) { return ScalarReal(i); }
-SEXP newRealFromIntImpl(int i) { return ScalarReal(i == NA_INTEGER ? NAN : i); }
+SEXP newRealImpl(double i) {
+    RuntimeStats::count(RuntimeStats::NativeBoxes);
+    return ScalarReal(i);
+}
+SEXP newRealFromIntImpl(int i) {
+    RuntimeStats::count(RuntimeStats::NativeBoxes);
+    return ScalarReal(i == NA_INTEGER ? NAN : i);
+}
 
 NativeBuiltin NativeBuiltins::newIntFromReal = {
     "newIntFromReal",
@@ -989,7 +1074,12 @@ NativeBuiltin NativeBuiltins::length = {
     {llvm::Attribute::ReadOnly, llvm::Attribute::ArgMemOnly}};
 
 void deoptImpl(Code* c, SEXP cls, DeoptMetadata* m, R_bcstack_t* args) {
-    if (!pir::Parameter::DEOPT_CHAOS) {
+    bool continuation = pir::Deoptless::dropContinuation(c, cls);
+    if (continuation) {
+        // Continuations are only called by Deoptless, so it is enough to keep
+        // this one alive until the deopt is done
+        PROTECT(c->container());
+    } else if (!pir::Parameter::DEOPT_CHAOS) {
         if (cls) {
             // TODO: this version is still reachable from static call inline
             // caches. Thus we need to preserve it forever. We need some
@@ -1014,7 +1104,13 @@ void deoptImpl(Code* c, SEXP cls, DeoptMetadata* m, R_bcstack_t* args) {
         stackHeight += m->frames[i].stackSize + 1;
     }
 
-    c->registerDeopt();
+    // Only deopts which cannot be blamed on a single speculation count
+    // towards giving up on the function (see PIR_DEOPT_ABANDON)
+    if (!deoptHasSite())
+        c->registerDeopt();
+    RuntimeStats::count(RuntimeStats::Deopts);
+    if (!continuation)
+        pir::Deoptless::continueFrame(c, cls, m);
     SEXP env =
         ostack_at(ctx, stackHeight - m->frames[m->numFrames - 1].stackSize - 1);
     CallContext call(ArglistOrder::NOT_REORDERED, c, cls,
@@ -1424,33 +1520,66 @@ static void endClosureContext(RCNTXT* cntxt, SEXP result) {
     Rf_endcontext(cntxt);
 }
 
-static SEXP nativeCallTrampolineImpl(ArglistOrder::CallId callId, rir::Code* c,
-                                     SEXP callee, Immediate target,
-                                     Immediate astP, SEXP env, size_t nargs,
-                                     unsigned long available) {
-    SLOWASSERT(env == symbol::delayedEnv || TYPEOF(env) == ENVSXP ||
-               env == R_NilValue || LazyEnvironment::check(env));
+// Calls the native body of a version with the closure context it needs. The
+// context is skipped for versions which can never observe or unwind to it.
+static SEXP nativeCallWithContext(const CallContext& call, Code* body,
+                                  R_bcstack_t* args) {
+    auto env = call.callerEnv;
+    auto callee = call.callee;
+    // Native calls do not go through evalRirCode, which registers the other
+    // frames
+    SamplingProfiler::Frame profilerFrame(body, &call, false, false);
+    if (body->flags.contains(Code::NoContext))
+        return body->nativeCode(body, args, env, callee);
+
+    LazyArglistOnStack lazyArgs(call.callId,
+                                call.caller->arglistOrderContainer(),
+                                call.suppliedArgs, call.stackArgs, call.ast);
+
+    RCNTXT cntxt;
+    initClosureContext(call.ast, &cntxt, symbol::delayedEnv, env,
+                       lazyArgs.asSexp(), callee);
+    R_Srcref = getAttrib(callee, symbol::srcref);
+
+    // TODO debug
+
+    SEXP result = rirCallTrampoline_(cntxt, body, args, env, callee);
 
-    auto fun = Function::unpack(Pool::get(target));
+    endClosureContext(&cntxt, result);
+
+    PROTECT(result);
+    R_Srcref = cntxt.srcref;
+    R_ReturnedValue = R_NilValue;
+    UNPROTECT(1);
+    return result;
+}
 
+// Calls the version a call site is bound to, without going through
+// dispatch. Falls back to doCall (and rebinds the site) if the version does
+// not fit the arguments, wants to be recompiled or the feedback of the callee
+// is observed (see FeedbackWindow).
+static SEXP nativeCallBound(CallContext& call, Function* fun,
+                            Immediate target) {
     auto ctx = globalContext();
-    CallContext call(callId, c, callee, nargs, astP,
-                     ostack_cell_at(ctx, nargs - 1), env, Context(available),
-                     ctx);
+    auto callee = call.callee;
+    auto nargs = call.suppliedArgs;
+    auto available = call.givenContext;
 
     auto fail = !call.givenContext.smaller(fun->context());
     if (fail) {
         inferCurrentContext(call, fun->nargs(), ctx);
         fail = !call.givenContext.smaller(fun->context());
     }
-    if (!fun->body()->nativeCode)
+    if (!fun->body()->nativeCode || nargs > fun->nargs())
         fail = true;
 
     auto dt = DispatchTable::unpack(BODY(callee));
+    if (!fail && FeedbackWindow::bypass(dt))
+        fail = true;
 
     fun->registerInvocation();
     if (fail || RecompileHeuristic(dt, fun, 6)) {
-        if (fail || RecompileCondition(dt, fun, Context(available))) {
+        if (fail || RecompileCondition(dt, fun, available)) {
             fun->unregisterInvocation();
             return callImplCached(call, target);
         }
@@ -1463,52 +1592,89 @@ static SEXP nativeCallTrampolineImpl(ArglistOrder::CallId callId, rir::Code* c,
         ostack_push(globalContext(), R_MissingArg);
 
     R_bcstack_t* args = ostack_cell_at(ctx, nargs + missing - 1);
-    auto ast = cp_pool_at(globalContext(), astP);
-
-    LazyArglistOnStack lazyArgs(call.callId,
-                                call.caller->arglistOrderContainer(),
-                                call.suppliedArgs, call.stackArgs, call.ast);
 
     assert(fun->signature().envCreation ==
            FunctionSignature::Environment::CalleeCreated);
 
-    RCNTXT cntxt;
-
     // This code needs to be protected, because its slot in the dispatch table
     // could get overwritten while we are executing it.
     PROTECT(fun->container());
-
-    initClosureContext(ast, &cntxt, symbol::delayedEnv, env, lazyArgs.asSexp(),
-                       callee);
-    R_Srcref = getAttrib(callee, symbol::srcref);
-
-    // TODO debug
-
-    SEXP result = rirCallTrampoline_(cntxt, fun->body(), args, env, callee);
-
-    endClosureContext(&cntxt, result);
-
-    PROTECT(result);
-    R_Srcref = cntxt.srcref;
-    R_ReturnedValue = R_NilValue;
-
-    UNPROTECT(2);
+    auto result = nativeCallWithContext(call, fun->body(), args);
+    UNPROTECT(1);
     ostack_popn(globalContext(), missing);
 
     assert(t == R_BCNodeStackTop);
     return result;
 }
 
+static SEXP nativeCallTrampolineImpl(ArglistOrder::CallId callId, rir::Code* c,
+                                     SEXP callee, Immediate target,
+                                     Immediate astP, SEXP env, size_t nargs,
+                                     unsigned long available) {
+    SLOWASSERT(env == symbol::delayedEnv || TYPEOF(env) == ENVSXP ||
+               env == R_NilValue || LazyEnvironment::check(env));
+
+    auto ctx = globalContext();
+    CallContext call(callId, c, callee, nargs, astP,
+                     ostack_cell_at(ctx, nargs - 1), env, Context(available),
+                     ctx);
+
+    if (auto fun = boundCallTarget(target, callee))
+        return nativeCallBound(call, fun, target);
+    return callImplCached(call, target);
+}
+
 NativeBuiltin NativeBuiltins::nativeCallTrampoline = {
     "nativeCallTrampoline",
     (void*)&nativeCallTrampolineImpl,
 };
 
+// Self calls of the version which is running, c is its body. They do not go
+// through dispatch, but need the same closure context as any other call.
+static SEXP nativeCallSelfImpl(ArglistOrder::CallId callId, rir::Code* c,
+                               Immediate ast, SEXP callee, SEXP env,
+                               size_t nargs) {
+    auto ctx = globalContext();
+    CallContext call(callId, c, callee, nargs, ast,
+                     ostack_cell_at(ctx, nargs - 1), env, Context(), ctx);
+    return nativeCallWithContext(call, c, call.stackArgs);
+}
+
+NativeBuiltin NativeBuiltins::nativeCallSelf = {
+    "nativeCallSelf",
+    (void*)&nativeCallSelfImpl,
+};
+
+static SEXP callCachedImpl(ArglistOrder::CallId callId, rir::Code* c,
+                           Immediate ast, SEXP callee, SEXP env, size_t nargs,
+                           unsigned long available, Immediate target) {
+    SLOWASSERT(env == symbol::delayedEnv || TYPEOF(env) == ENVSXP ||
+               LazyEnvironment::check(env) || env == R_NilValue);
+
+    auto ctx = globalContext();
+    CallContext call(callId, c, callee, nargs, ast,
+                     ostack_cell_at(ctx, nargs - 1), env, Context(available),
+                     ctx);
+
+    if (auto fun = boundCallTarget(target, callee))
+        return nativeCallBound(call, fun, target);
+    return callImplCached(call, target);
+}
+
+NativeBuiltin NativeBuiltins::callCached = {
+    "callCached",
+    (void*)&callCachedImpl,
+};
+
 SEXP subassign11Impl(SEXP vector, SEXP index, SEXP value, SEXP env,
                      Immediate srcIdx) {
     if (MAYBE_SHARED(vector))
         vector = Rf_shallow_duplicate(vector);
     PROTECT(vector);
+    if (auto res = appendScalar(vector, index, value)) {
+        UNPROTECT(1);
+        return res;
+    }
     SEXP args = CONS_NR(vector, CONS_NR(index, CONS_NR(value, R_NilValue)));
     SET_TAG(CDDR(args), symbol::value);
     PROTECT(args);
@@ -1585,6 +1751,11 @@ SEXP subassign21Impl(SEXP vec, SEXP idx, SEXP val, SEXP env, Immediate srcIdx) {
         }
     }
 
+    if (auto res = appendScalar(vec, idx, val)) {
+        UNPROTECT(prot);
+        return res;
+    }
+
     SEXP args = CONS_NR(vec, CONS_NR(idx, CONS_NR(val, R_NilValue)));
     SET_TAG(CDDR(args), symbol::value);
     PROTECT(args);
@@ -1871,6 +2042,15 @@ NativeBuiltin NativeBuiltins::subassign13 = {
     (void*)subassign13Impl,
 };
 
+SEXP appendImpl(SEXP vec, SEXP val, SEXP env, Immediate srcIdx) {
+    return appendVector(src_pool_at(globalContext(), srcIdx), vec, val, env);
+}
+
+NativeBuiltin NativeBuiltins::append = {
+    "append",
+    (void*)appendImpl,
+};
+
 SEXP subassign22Impl(SEXP vec, SEXP idx1, SEXP idx2, SEXP val, SEXP env,
                      Immediate srcIdx) {
     int prot = 0;
@@ -4,6 +4,7 @@
 #include "R/r_incl.h"
 #include "R_ext/Boolean.h"
 #include <cstddef>
+#include <cstdint>
 #include <llvm/IR/Attributes.h>
 #include <vector>
 
@@ -17,6 +18,8 @@ class FunctionType;
 }
 
 namespace rir {
+struct Function;
+
 namespace pir {
 
 struct NativeBuiltin {
@@ -62,6 +65,7 @@ struct NativeBuiltins {
     static NativeBuiltin ldvarGlobal;
     static NativeBuiltin ldvarForUpdate;
     static NativeBuiltin ldvarCacheMiss;
+    static NativeBuiltin ldvarForUpdateCacheMiss;
     static NativeBuiltin stvar;
     static NativeBuiltin stvarSuper;
     static NativeBuiltin stvari;
@@ -147,7 +151,11 @@ struct NativeBuiltins {
     static NativeBuiltin subassign22;
     static NativeBuiltin subassign13;
 
+    static NativeBuiltin append;
+
     static NativeBuiltin nativeCallTrampoline;
+    static NativeBuiltin nativeCallSelf;
+    static NativeBuiltin callCached;
 
     static NativeBuiltin initClosureContext;
     static NativeBuiltin endClosureContext;
@@ -183,6 +191,10 @@ struct NativeBuiltins {
     static constexpr unsigned long bindingsCacheFails = 2;
 };
 
+// Binds a native call site to a version of callee. The site is the constant
+// pool slot passed to nativeCallTrampoline or callCached.
+void bindCallSite(uint32_t site, SEXP callee, Function* fun);
+
 }
 }
 
@@ -1,6 +1,8 @@
 #include "jit_llvm.h"
 
 #include "compiler/parameter.h"
+#include "runtime/Code.h"
+#include "runtime_stats.h"
 #include "types_llvm.h"
 
 #include <llvm/ADT/STLExtras.h>
@@ -11,6 +13,7 @@
 #include <llvm/Analysis/TargetTransformInfo.h>
 #include <llvm/Analysis/TypeBasedAliasAnalysis.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/ExecutionEngine/JITEventListener.h>
 #include <llvm/ExecutionEngine/JITSymbol.h>
 #include <llvm/ExecutionEngine/Orc/CompileUtils.h>
 #include <llvm/ExecutionEngine/Orc/IRCompileLayer.h>
@@ -23,6 +26,7 @@
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Mangler.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/Object/SymbolSize.h>
 #include <llvm/Support/DynamicLibrary.h>
 #include <llvm/Support/Error.h>
 #include <llvm/Support/TargetSelect.h>
@@ -53,7 +57,10 @@
 #include <llvm/Transforms/IPO.h>
 #include <unordered_map>
 
+#include <cinttypes>
+#include <cstdio>
 #include <iostream>
+#include <unistd.h>
 
 namespace {
 
@@ -72,6 +79,25 @@ class JitLLVMImplementation {
     LegacyIRCompileLayer<decltype(ObjectLayer), SimpleCompiler> CompileLayer;
     std::unordered_map<std::string, std::pair<llvm::Function*, void*>>
         builtins_;
+    // Builtins used by all modules so far. Deferred modules are linked
+    // after builtins_ was reset for later modules.
+    std::unordered_map<std::string, void*> builtinAddresses_;
+
+    // Modules of promises which are not forced yet, together with the name of
+    // their function. They hang off their code object, such that they die
+    // with it.
+    struct Deferred {
+        std::unique_ptr<llvm::Module> module;
+        std::string name;
+        std::string profilerName;
+    };
+
+    // Support for profilers, see notifyLoaded. The name of the function which
+    // is currently emitted and the name it should have in profiles.
+    JITEventListener* jitdump_ = nullptr;
+    FILE* perfMap_ = nullptr;
+    std::string emitting_;
+    std::string profilerName_;
 
     using OptimizeFunction = std::function<std::unique_ptr<llvm::Module>(
         std::unique_ptr<llvm::Module>)>;
@@ -99,6 +125,10 @@ class JitLLVMImplementation {
                           return LegacyRTDyldObjectLinkingLayer::Resources{
                               std::make_shared<SectionMemoryManager>(),
                               Resolver};
+                      },
+                      [this](VModuleKey K, const object::ObjectFile& obj,
+                             const RuntimeDyld::LoadedObjectInfo& info) {
+                          notifyLoaded(K, obj, info);
                       }),
           CompileLayer(ObjectLayer, SimpleCompiler(*TM)),
           OptimizeLayer(CompileLayer,
@@ -109,6 +139,62 @@ class JitLLVMImplementation {
         llvm::sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
         TM->setMachineOutliner(true);
         TM->setFastISel(true);
+
+        if (rir::pir::Parameter::PIR_JITDUMP) {
+            jitdump_ = JITEventListener::createPerfJITEventListener();
+            if (!jitdump_)
+                std::cerr << "warning: LLVM was built without perf support, "
+                             "writing a perf map instead of a jitdump\n";
+        }
+        if (rir::pir::Parameter::PIR_PERF_MAP ||
+            (rir::pir::Parameter::PIR_JITDUMP && !jitdump_)) {
+            auto path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+            perfMap_ = fopen(path.c_str(), "a");
+            if (!perfMap_)
+                std::cerr << "warning: cannot open " << path << "\n";
+        }
+    }
+
+    // Called for every object file, after its sections got their final
+    // addresses. Counts the emitted code and registers the functions with the
+    // profilers, by default native code is just anonymous memory to them.
+    void notifyLoaded(VModuleKey K, const object::ObjectFile& obj,
+                      const RuntimeDyld::LoadedObjectInfo& info) {
+        for (auto& section : obj.sections())
+            if (section.isText())
+                rir::RuntimeStats::count(rir::RuntimeStats::NativeCodeBytes,
+                                         section.getSize());
+
+        if (jitdump_)
+            jitdump_->notifyObjectLoaded(K, obj, info);
+        if (!perfMap_)
+            return;
+
+        // Symbols of the debug object are relocated to their load address
+        auto debugObj = info.getObjectForDebug(obj);
+        if (!debugObj.getBinary())
+            return;
+        for (auto& s : object::computeSymbolSizes(*debugObj.getBinary())) {
+            auto& sym = s.first;
+            auto type = sym.getType();
+            auto name = sym.getName();
+            auto addr = sym.getAddress();
+            if (!type || !name || !addr) {
+                consumeError(type.takeError());
+                consumeError(name.takeError());
+                consumeError(addr.takeError());
+                continue;
+            }
+            if (*type != object::SymbolRef::ST_Function || !s.second)
+                continue;
+            // Outlined cold parts are listed under their own name
+            auto label = profilerName_;
+            if (*name != emitting_)
+                label += " " + name->str();
+            fprintf(perfMap_, "%" PRIx64 " %" PRIx64 " %s\n", *addr,
+                    s.second, label.c_str());
+        }
+        fflush(perfMap_);
     }
 
     std::unordered_map<rir::pir::ClosureVersion*, llvm::Function*> funs;
@@ -147,6 +233,7 @@ class JitLLVMImplementation {
             f->addFnAttr(a);
 
         builtins_[b.name] = {f, b.fun};
+        builtinAddresses_[b.name] = b.fun;
         return f;
     }
 
@@ -157,7 +244,7 @@ class JitLLVMImplementation {
         return nullptr;
     }
 
-    void* compile(llvm::Function* fun) {
+    void* compile(llvm::Function* fun, const std::string& profilerName) {
         auto name = fun->getName().str();
 
         verifyFunction(*fun);
@@ -165,6 +252,9 @@ class JitLLVMImplementation {
         cantFail(OptimizeLayer.addModule(
             moduleKey, std::unique_ptr<llvm::Module>(module)));
         module = nullptr;
+        // Code is emitted on the first lookup
+        emitting_ = mangle(name);
+        profilerName_ = profilerName;
         auto res = findSymbol(name);
         auto adr = res.getAddress();
         // cantFail(OptimizeLayer.removeModule(K));
@@ -175,6 +265,49 @@ class JitLLVMImplementation {
         return nullptr;
     }
 
+    static void dropDeferred(SEXP ptr) {
+        delete static_cast<Deferred*>(R_ExternalPtrAddr(ptr));
+        R_ClearExternalPtr(ptr);
+    }
+
+    // Keeps the module of fun without optimizing or generating code for it.
+    // The target gets a stub which compiles it on first invocation.
+    void compileLazy(rir::Code* target, llvm::Function* fun,
+                     const std::string& profilerName) {
+        verifyFunction(*fun);
+        auto deferred = new Deferred{std::unique_ptr<llvm::Module>(module),
+                                     fun->getName().str(), profilerName};
+        module = nullptr;
+        SEXP ptr = R_MakeExternalPtr(deferred, R_NilValue, R_NilValue);
+        PROTECT(ptr);
+        R_RegisterCFinalizerEx(ptr, &dropDeferred, FALSE);
+        target->deferredNativeCode(ptr);
+        UNPROTECT(1);
+        target->nativeCode = &lazyCompileStub;
+    }
+
+    rir::NativeCode materialize(rir::Code* target) {
+        SEXP ptr = target->deferredNativeCode();
+        assert(ptr);
+        auto deferred = static_cast<Deferred*>(R_ExternalPtrAddr(ptr));
+        auto key = ES.allocateVModule();
+        cantFail(OptimizeLayer.addModule(key, std::move(deferred->module)));
+        emitting_ = mangle(deferred->name);
+        profilerName_ = deferred->profilerName;
+        auto sym = CompileLayer.findSymbolIn(key, emitting_, true);
+        auto adr = sym.getAddress();
+        dropDeferred(ptr);
+        target->deferredNativeCode(nullptr);
+        assert(adr && *adr);
+        return (rir::NativeCode)*adr;
+    }
+
+    static SEXP lazyCompileStub(rir::Code* c, void* args, SEXP env,
+                                SEXP callee) {
+        c->nativeCode = instance().materialize(c);
+        return c->nativeCode(c, args, env, callee);
+    }
+
     static JitLLVMImplementation& instance() {
         static std::unique_ptr<JitLLVMImplementation> singleton;
         if (!singleton) {
@@ -202,9 +335,9 @@ class JitLLVMImplementation {
 
   private:
     JITSymbol findMangledSymbol(const std::string& Name) {
-        auto l = builtins_.find(Name);
-        if (l != builtins_.end()) {
-            return JITSymbol((uintptr_t)l->second.second,
+        auto l = builtinAddresses_.find(Name);
+        if (l != builtinAddresses_.end()) {
+            return JITSymbol((uintptr_t)l->second,
                              JITSymbolFlags::Exported |
                                  JITSymbolFlags::Callable);
         }
@@ -466,8 +599,13 @@ void JitLLVM::createModule() {
     JitLLVMImplementation::instance().createModule();
 }
 
-void* JitLLVM::compile(llvm::Function* fun) {
-    return JitLLVMImplementation::instance().compile(fun);
+void* JitLLVM::compile(llvm::Function* fun, const std::string& profilerName) {
+    return JitLLVMImplementation::instance().compile(fun, profilerName);
+}
+
+void JitLLVM::compileLazy(rir::Code* target, llvm::Function* fun,
+                          const std::string& profilerName) {
+    JitLLVMImplementation::instance().compileLazy(target, fun, profilerName);
 }
 
 llvm::Function* JitLLVM::get(ClosureVersion* v) {
@@ -502,6 +640,14 @@ llvm::Module& JitLLVM::module() {
 
 unsigned Parameter::PIR_LLVM_OPT_LEVEL =
     getenv("PIR_LLVM_OPT_LEVEL") ? atoi(getenv("PIR_LLVM_OPT_LEVEL")) : 2;
+bool Parameter::PIR_LLVM_LAZY_PROMISES =
+    getenv("PIR_LLVM_LAZY_PROMISES")
+        ? atoi(getenv("PIR_LLVM_LAZY_PROMISES")) != 0
+        : true;
+bool Parameter::PIR_PERF_MAP =
+    getenv("PIR_PERF_MAP") ? atoi(getenv("PIR_PERF_MAP")) != 0 : false;
+bool Parameter::PIR_JITDUMP =
+    getenv("PIR_JITDUMP") ? atoi(getenv("PIR_JITDUMP")) != 0 : false;
 
 } // namespace pir
 } // namespace rir
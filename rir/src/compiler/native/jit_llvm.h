@@ -7,6 +7,8 @@
 #include "llvm/IR/IRBuilder.h"
 
 namespace rir {
+struct Code;
+
 namespace pir {
 
 class ClosureVersion;
@@ -16,7 +18,10 @@ class JitLLVM {
     static llvm::LLVMContext C;
     static void createModule();
     static llvm::Module& module();
-    static void* compile(llvm::Function*);
+    // profilerName is the name the code has in perf maps and jitdumps
+    static void* compile(llvm::Function*, const std::string& profilerName);
+    static void compileLazy(rir::Code* target, llvm::Function*,
+                            const std::string& profilerName);
     static llvm::Function* declare(ClosureVersion* v, const std::string& name,
                                    llvm::FunctionType* signature);
     static llvm::Function* getBuiltin(const NativeBuiltin&);
@@ -359,6 +359,8 @@ llvm::Value* LowerFunctionLLVM::load(Value* val, PirType type,
     else if (auto e = Env::Cast(val)) {
         if (e == Env::notClosed()) {
             res = tag(paramClosure());
+        } else if (e == Env::frame()) {
+            res = paramEnv();
         } else if (e == Env::nil()) {
             res = constant(R_NilValue, needed);
         } else if (Env::isStaticEnv(e)) {
@@ -1117,12 +1119,33 @@ void LowerFunctionLLVM::ensureNamedIfNeeded(Instruction* i, llvm::Value* val) {
             } else if (adjust->second == NeedsRefcountAdjustment::EnsureNamed) {
                 if (!val)
                     val = load(i);
-                ensureShared(val);
+                ensureNamed(val);
             }
         }
     }
 }
 
+void LowerFunctionLLVM::createVectorView(Instruction* i) {
+    if (inPushContext || !variables_.count(i) || !variables_.at(i).initialized)
+        return;
+    auto v = load(i);
+    vectorViews[i] = {isAltrep(v), vectorLength(v)};
+}
+
+llvm::Value* LowerFunctionLLVM::viewIsAltrep(Value* v, llvm::Value* vector) {
+    auto view = vectorViews.find(v);
+    if (view != vectorViews.end())
+        return view->second.altrep;
+    return isAltrep(vector);
+}
+
+llvm::Value* LowerFunctionLLVM::viewLength(Value* v) {
+    auto view = vectorViews.find(v);
+    if (view != vectorViews.end())
+        return view->second.length;
+    return nullptr;
+}
+
 void LowerFunctionLLVM::ensureNamed(llvm::Value* v) {
     assert(v->getType() == t::SEXP);
     auto sxpinfoP = builder.CreateBitCast(sxpinfoPtr(v), t::i64ptr);
@@ -2026,6 +2049,24 @@ void LowerFunctionLLVM::compile() {
         });
     }
 
+    Visitor::run(code->entry, [&](Instruction* i) {
+        Value* vec = nullptr;
+        if (auto e = Extract1_1D::Cast(i))
+            vec = e->vec();
+        else if (auto e = Extract2_1D::Cast(i))
+            vec = e->vec();
+        else if (auto s = Subassign1_1D::Cast(i))
+            vec = s->vector();
+        else if (auto s = Subassign2_1D::Cast(i))
+            vec = s->vector();
+        // Phis are updated on every iteration, their header cannot be cached
+        // at the definition.
+        auto vi = vec ? Instruction::Cast(vec) : nullptr;
+        if (vi && !Phi::Cast(vi) && Representation::Of(vi) == t::SEXP &&
+            vectorTypeSupport(vi))
+            needsVectorView.insert(vi);
+    });
+
     numLocals += MAX_TEMPS;
     if (numLocals > 1)
         incStack(numLocals - 1, true);
@@ -2932,11 +2973,15 @@ void LowerFunctionLLVM::compile() {
                 if (b->isReordered())
                     callId = pushArgReordering(b->getArgOrderOrig());
 
+                // The call site binds to the version it dispatched to last
+                // and calls it directly while the callee stays the same.
+                auto site = Pool::makeSpace();
                 setVal(i, withCallFrame(args, [&]() -> llvm::Value* {
-                           return call(NativeBuiltins::call,
+                           return call(NativeBuiltins::callCached,
                                        {c(callId), paramCode(), c(b->srcIdx),
                                         loadSxp(b->cls()), loadSxp(b->env()),
-                                        c(b->nCallArgs()), c(asmpt.toI())});
+                                        c(b->nCallArgs()), c(asmpt.toI()),
+                                        c(site)});
                        }));
                 break;
             }
@@ -3003,6 +3048,27 @@ void LowerFunctionLLVM::compile() {
                     break;
                 }
 
+                // Self calls do not have a dispatch table entry yet, they
+                // call the body we are running right now directly. They still
+                // need a closure context, for deopts and non-local returns.
+                if (target == cls && code == cls &&
+                    calli->nCallArgs() == target->nargs() &&
+                    target->properties.includes(
+                        ClosureVersion::Property::NoReflection)) {
+                    auto callee =
+                        calli->runtimeClosure() == Tombstone::closure()
+                            ? constant(target->owner()->rirClosure(), t::SEXP)
+                            : loadSxp(calli->runtimeClosure());
+                    setVal(i, withCallFrame(args, [&]() -> llvm::Value* {
+                               return call(NativeBuiltins::nativeCallSelf,
+                                           {c(callId), paramCode(),
+                                            c(calli->srcIdx), callee,
+                                            loadSxp(i->env()),
+                                            c(calli->nCallArgs())});
+                           }));
+                    break;
+                }
+
                 if (target == bestTarget) {
                     auto callee = target->owner()->rirClosure();
                     auto dt = DispatchTable::check(BODY(callee));
@@ -3036,7 +3102,7 @@ void LowerFunctionLLVM::compile() {
                         assert(
                             asmpt.includes(Assumption::StaticallyArgmatched));
                         auto idx = Pool::makeSpace();
-                        Pool::patch(idx, nativeTarget->container());
+                        bindCallSite(idx, callee, nativeTarget);
                         assert(asmpt.smaller(nativeTarget->context()));
                         auto res = withCallFrame(args, [&]() {
                             return call(NativeBuiltins::nativeCallTrampoline,
@@ -3779,16 +3845,41 @@ void LowerFunctionLLVM::compile() {
                         res =
                             builder.CreateAnd(res, builder.CreateNot(isObj(a)));
                     }
+                    // Feedback can tell us that a scalar is never NA
+                    if (arg->type.maybeNAOrNaN() &&
+                        !t->typeTest.maybeNAOrNaN()) {
+                        auto tt = t->typeTest.notPromiseWrapped();
+                        assert(tt.isA(PirType::simpleScalar()));
+                        res = createSelect2(
+                            res,
+                            [&]() -> llvm::Value* {
+                                if (tt.isA(RType::real)) {
+                                    auto v = unboxReal(a);
+                                    return builder.CreateFCmpOEQ(v, v);
+                                }
+                                auto v = tt.isA(RType::integer) ? unboxInt(a)
+                                                                : unboxLgl(a);
+                                return builder.CreateICmpNE(v, c(NA_INTEGER));
+                            },
+                            [&]() { return builder.getFalse(); });
+                    }
                     setVal(i, builder.CreateZExt(res, t::Int));
                 } else {
+                    llvm::Value* res = builder.getTrue();
                     if (Representation::Of(arg) == t::Double &&
                         arg->type.maybe(RType::real) &&
                         !t->typeTest.maybe(RType::real)) {
-                        setVal(i, builder.CreateZExt(
-                                      checkDoubleToInt(load(arg)), t::Int));
-                    } else {
-                        setVal(i, c(1));
+                        res = checkDoubleToInt(load(arg));
+                    }
+                    if (arg->type.maybeNAOrNaN() &&
+                        !t->typeTest.maybeNAOrNaN()) {
+                        auto v = load(arg);
+                        res = builder.CreateAnd(
+                            res, v->getType() == t::Double
+                                     ? builder.CreateFCmpOEQ(v, v)
+                                     : builder.CreateICmpNE(v, c(NA_INTEGER)));
                     }
+                    setVal(i, builder.CreateZExt(res, t::Int));
                 }
                 break;
             }
@@ -4109,11 +4200,12 @@ void LowerFunctionLLVM::compile() {
                     builder.CreateBr(done);
 
                     builder.SetInsertPoint(miss);
-                    auto res0 = call(NativeBuiltins::ldvarCacheMiss,
-                                     {constant(varName, t::SEXP),
-                                      loadSxp(i->env()), cachePtr});
-                    if (needsLdVarForUpdate.count(i))
-                        ensureShared(res0);
+                    auto res0 =
+                        call(needsLdVarForUpdate.count(i)
+                                 ? NativeBuiltins::ldvarForUpdateCacheMiss
+                                 : NativeBuiltins::ldvarCacheMiss,
+                             {constant(varName, t::SEXP), loadSxp(i->env()),
+                              cachePtr});
                     phi.addInput(res0);
                     builder.CreateBr(done);
                     builder.SetInsertPoint(done);
@@ -4158,7 +4250,8 @@ void LowerFunctionLLVM::compile() {
 
                     if (Representation::Of(extract->vec()) == t::SEXP) {
                         auto hit2 = BasicBlock::Create(C, "", fun);
-                        builder.CreateCondBr(isAltrep(vector), fallback, hit2,
+                        auto altrep = viewIsAltrep(extract->vec(), vector);
+                        builder.CreateCondBr(altrep, fallback, hit2,
                                              branchMostlyFalse);
                         builder.SetInsertPoint(hit2);
 
@@ -4172,7 +4265,8 @@ void LowerFunctionLLVM::compile() {
                     }
 
                     llvm::Value* index =
-                        computeAndCheckIndex(extract->idx(), vector, fallback);
+                        computeAndCheckIndex(extract->idx(), vector, fallback,
+                                             viewLength(extract->vec()));
                     auto res0 =
                         extract->vec()->type.isScalar()
                             ? vector
@@ -4295,13 +4389,15 @@ void LowerFunctionLLVM::compile() {
                     llvm::Value* vector = load(extract->vec());
 
                     if (Representation::Of(extract->vec()) == t::SEXP) {
-                        builder.CreateCondBr(isAltrep(vector), fallback, hit2,
+                        auto altrep = viewIsAltrep(extract->vec(), vector);
+                        builder.CreateCondBr(altrep, fallback, hit2,
                                              branchMostlyFalse);
                         builder.SetInsertPoint(hit2);
                     }
 
                     llvm::Value* index =
-                        computeAndCheckIndex(extract->idx(), vector, fallback);
+                        computeAndCheckIndex(extract->idx(), vector, fallback,
+                                             viewLength(extract->vec()));
                     auto res0 =
                         extract->vec()->type.isScalar()
                             ? vector
@@ -4471,6 +4567,16 @@ void LowerFunctionLLVM::compile() {
                 break;
             }
 
+            case Tag::Append: {
+                auto append = Append::Cast(i);
+                auto res = call(NativeBuiltins::append,
+                                {loadSxp(append->vector()),
+                                 loadSxp(append->val()),
+                                 loadSxp(append->env()), c(append->srcIdx)});
+                setVal(i, res);
+                break;
+            }
+
             case Tag::Subassign1_2D: {
                 auto subAssign = Subassign1_2D::Cast(i);
                 auto vector = loadSxp(subAssign->lhs());
@@ -4625,7 +4731,8 @@ void LowerFunctionLLVM::compile() {
                     llvm::Value* vector = load(subAssign->vector());
                     if (Representation::Of(subAssign->vector()) == t::SEXP) {
                         auto hit1 = BasicBlock::Create(C, "", fun);
-                        builder.CreateCondBr(isAltrep(vector), fallback, hit1,
+                        auto altrep = viewIsAltrep(subAssign->vector(), vector);
+                        builder.CreateCondBr(altrep, fallback, hit1,
                                              branchMostlyFalse);
                         builder.SetInsertPoint(hit1);
 
@@ -4640,8 +4747,9 @@ void LowerFunctionLLVM::compile() {
                         vector = cloneIfShared(vector);
                     }
 
-                    llvm::Value* index = computeAndCheckIndex(subAssign->idx(),
-                                                              vector, fallback);
+                    llvm::Value* index =
+                        computeAndCheckIndex(subAssign->idx(), vector, fallback,
+                                             viewLength(subAssign->vector()));
 
                     auto val = load(subAssign->val());
                     if (Representation::Of(i) == Representation::Sexp) {
@@ -4706,14 +4814,16 @@ void LowerFunctionLLVM::compile() {
                     llvm::Value* vector = load(subAssign->vector());
                     if (Representation::Of(subAssign->vector()) == t::SEXP) {
                         auto hit1 = BasicBlock::Create(C, "", fun);
-                        builder.CreateCondBr(isAltrep(vector), fallback, hit1,
+                        auto altrep = viewIsAltrep(subAssign->vector(), vector);
+                        builder.CreateCondBr(altrep, fallback, hit1,
                                              branchMostlyFalse);
                         builder.SetInsertPoint(hit1);
                         vector = cloneIfShared(vector);
                     }
 
-                    llvm::Value* index = computeAndCheckIndex(subAssign->idx(),
-                                                              vector, fallback);
+                    llvm::Value* index =
+                        computeAndCheckIndex(subAssign->idx(), vector, fallback,
+                                             viewLength(subAssign->vector()));
 
                     auto val = load(subAssign->val());
                     if (Representation::Of(i) == Representation::Sexp) {
@@ -5180,6 +5290,8 @@ void LowerFunctionLLVM::compile() {
             ++currentInstr;
             if (!Phi::Cast(i))
                 ensureNamedIfNeeded(i);
+            if (needsVectorView.count(i))
+                createVectorView(i);
 
             if (Parameter::RIR_CHECK_PIR_TYPES > 0 && !i->type.isVoid() &&
                 variables_.count(i)) {
@@ -56,6 +56,17 @@ class LowerFunctionLLVM {
 
     std::vector<ArglistOrder::CallArglistOrder> argReordering;
 
+    // Vectors indexed by the native fast paths get their altrep bit and
+    // length loaded once, right after their definition. The fast paths then
+    // use these SSA values instead of reloading the header on every access,
+    // which lets LLVM keep them in registers across loops.
+    struct VectorView {
+        llvm::Value* altrep;
+        llvm::Value* length;
+    };
+    std::unordered_set<Instruction*> needsVectorView;
+    std::unordered_map<Value*, VectorView> vectorViews;
+
     std::unordered_map<Value*, std::unordered_map<SEXP, size_t>> bindingsCache;
     llvm::Value* bindingsCacheBase = nullptr;
 
@@ -320,6 +331,9 @@ class LowerFunctionLLVM {
     llvm::Value* isObj(llvm::Value*);
     llvm::Value* fastVeceltOkNative(llvm::Value*);
     llvm::Value* isAltrep(llvm::Value*);
+    void createVectorView(Instruction* i);
+    llvm::Value* viewIsAltrep(Value* v, llvm::Value* vector);
+    llvm::Value* viewLength(Value* v);
     llvm::Value* sxpinfoPtr(llvm::Value*);
 
     llvm::Value* container(llvm::Value*);
@@ -1,7 +1,10 @@
 #include "lower_llvm.h"
+#include "compiler/parameter.h"
 #include "jit_llvm.h"
 #include "lower_function_llvm.h"
 
+#include <sstream>
+
 namespace rir {
 namespace pir {
 
@@ -20,7 +23,22 @@ void LowerLLVM::compile(
         target->pirTypeFeedback(funCompiler.pirTypeFeedback);
     if (funCompiler.hasArgReordering())
         target->arglistOrder(ArglistOrder::New(funCompiler.getArgReordering()));
-    auto native = JitLLVM::compile(funCompiler.fun);
+
+    std::string profilerName;
+    if (Parameter::PIR_PERF_MAP || Parameter::PIR_JITDUMP) {
+        std::stringstream name;
+        name << "rir:" << cls->name() << " " << cls->context();
+        if (code != cls)
+            name << " " << *static_cast<Promise*>(code);
+        profilerName = name.str();
+    }
+    // Most promises are never forced, their code is only generated on the
+    // first force.
+    if (code != cls && Parameter::PIR_LLVM_LAZY_PROMISES) {
+        JitLLVM::compileLazy(target, funCompiler.fun, profilerName);
+        return;
+    }
+    auto native = JitLLVM::compile(funCompiler.fun, profilerName);
     target->nativeCode = (NativeCode)native;
 }
 
@@ -156,6 +156,8 @@ int initializeTypes(LLVMContext& context) {
     NativeBuiltins::ldvarForUpdate.llvmSignature = t::sexp_sexpsexp;
     NativeBuiltins::ldvarCacheMiss.llvmSignature = llvm::FunctionType::get(
         t::SEXP, {t::SEXP, t::SEXP, t::SEXP_ptr}, false);
+    NativeBuiltins::ldvarForUpdateCacheMiss.llvmSignature =
+        NativeBuiltins::ldvarCacheMiss.llvmSignature;
     NativeBuiltins::stvar.llvmSignature = t::void_sexpsexpsexp;
     NativeBuiltins::stvarSuper.llvmSignature = t::void_sexpsexpsexp;
     NativeBuiltins::stvari.llvmSignature =
@@ -215,6 +217,10 @@ int initializeTypes(LLVMContext& context) {
     NativeBuiltins::call.llvmSignature = llvm::FunctionType::get(
         t::SEXP, {t::i64, t::voidPtr, t::Int, t::SEXP, t::SEXP, t::i64, t::i64},
         false);
+    NativeBuiltins::callCached.llvmSignature = llvm::FunctionType::get(
+        t::SEXP,
+        {t::i64, t::voidPtr, t::Int, t::SEXP, t::SEXP, t::i64, t::i64, t::Int},
+        false);
     NativeBuiltins::dotsCall.llvmSignature =
         llvm::FunctionType::get(t::SEXP,
                                 {t::i64, t::voidPtr, t::Int, t::SEXP, t::SEXP,
@@ -302,12 +308,17 @@ int initializeTypes(LLVMContext& context) {
     NativeBuiltins::subassign13.llvmSignature = llvm::FunctionType::get(
         t::SEXP, {t::SEXP, t::SEXP, t::SEXP, t::SEXP, t::SEXP, t::SEXP, t::Int},
         false);
+    NativeBuiltins::append.llvmSignature = llvm::FunctionType::get(
+        t::SEXP, {t::SEXP, t::SEXP, t::SEXP, t::Int}, false);
 
     NativeBuiltins::nativeCallTrampoline.llvmSignature =
         llvm::FunctionType::get(t::SEXP,
                                 {t::i64, t::voidPtr, t::SEXP, t::Int, t::Int,
                                  t::SEXP, t::i64, t::i64},
                                 false);
+    NativeBuiltins::nativeCallSelf.llvmSignature = llvm::FunctionType::get(
+        t::SEXP, {t::i64, t::voidPtr, t::Int, t::SEXP, t::SEXP, t::i64},
+        false);
 
     NativeBuiltins::unop.llvmSignature = t::sexp_sexpint;
     NativeBuiltins::unopEnv.llvmSignature = t::sexp_sexp2int2;
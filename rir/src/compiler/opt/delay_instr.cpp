@@ -1,6 +1,7 @@
 #include "../pir/pir_impl.h"
 #include "../util/visitor.h"
 #include "compiler/analysis/cfg.h"
+#include "compiler/analysis/escape.h"
 #include "compiler/util/safe_builtins_list.h"
 #include "pass_definitions.h"
 
@@ -11,7 +12,17 @@ bool DelayInstr::apply(Compiler&, ClosureVersion* cls, Code* code,
                        LogStream&) const {
     bool anyChange = false;
 
-    auto isTarget = [](Instruction* j) {
+    // Environments which only escape on deopt are created in the deopt
+    // branches. We cannot move them across contexts, since they are
+    // registered with the innermost one.
+    const EscapeAnalysis escape(code);
+    bool hasContexts = false;
+    Visitor::run(code->entry, [&](Instruction* i) {
+        if (PushContext::Cast(i))
+            hasContexts = true;
+    });
+
+    auto isTarget = [&](Instruction* j) {
         int builtinId = -1;
         if (auto call = CallBuiltin::Cast(j))
             builtinId = call->builtinId;
@@ -24,6 +35,9 @@ bool DelayInstr::apply(Compiler&, ClosureVersion* cls, Code* code,
                 return SafeBuiltinsList::nonObjectIdempotent(builtinId);
             return SafeBuiltinsList::idempotent(builtinId);
         }
+        if (MkEnv::Cast(j))
+            return !hasContexts &&
+                   escape.at(j) == EscapeAnalysis::Escape::OnDeopt;
         return LdFun::Cast(j) || DotsList::Cast(j) || MkArg::Cast(j) ||
                FrameState::Cast(j) || CastType::Cast(j);
     };
@@ -12,6 +12,8 @@ bool Pass::apply(Compiler& cmp, ClosureVersion* function,
         function->eachPromise(
             [&](Promise* p) { res = apply(cmp, function, p, log) && res; });
     }
+    if (res)
+        function->changed();
     changedAnything_ = res;
     return res;
 }
@@ -154,6 +154,12 @@ class PASS(Overflow, true);
  */
 class PASS(HoistInstruction, false);
 
+/*
+ * Turns self calls in tail position into jumps back to the entry, if the
+ * version has no environment and does not need its frame.
+ */
+class PASS(TailRecursion, false);
+
 class PhaseMarker : public Pass {
   public:
     explicit PhaseMarker(const std::string& name) : Pass(name) {}
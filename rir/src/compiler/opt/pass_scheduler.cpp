@@ -104,6 +104,7 @@ PassScheduler::PassScheduler() {
 
     nextPhase("Final", 120);
     // ==== Phase 4) Final round of default opts
+    add<TailRecursion>();
     addDefaultOpt();
     add<ElideEnvSpec>();
     add<CleanupCheckpoints>();
@@ -0,0 +1,103 @@
+#include "../pir/pir_impl.h"
+#include "../util/visitor.h"
+#include "pass_definitions.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace rir {
+namespace pir {
+
+bool TailRecursion::apply(Compiler&, ClosureVersion* cls, Code* code,
+                          LogStream&) const {
+    // Without an environment and reflection nobody can observe that the
+    // frames of the recursive calls are reused.
+    if (!cls->properties.includes(ClosureVersion::Property::NoReflection))
+        return false;
+
+    bool hasEnv = false;
+    bool conflictingArgs = false;
+    std::unordered_map<size_t, LdArg*> args;
+    std::vector<LdArg*> duplicateArgs;
+    Visitor::run(code->entry, [&](Instruction* i) {
+        if (MkEnv::Cast(i))
+            hasEnv = true;
+        if (auto ld = LdArg::Cast(i)) {
+            auto a = args.find(ld->id);
+            if (a == args.end()) {
+                args[ld->id] = ld;
+            } else {
+                if (a->second->type != ld->type)
+                    conflictingArgs = true;
+                duplicateArgs.push_back(ld);
+            }
+        }
+    });
+    if (hasEnv || conflictingArgs)
+        return false;
+
+    // Find self calls, where the result is returned immediately and the
+    // arguments can be passed in place of our own.
+    std::vector<BB*> tails;
+    Visitor::run(code->entry, [&](BB* bb) {
+        if (bb->size() < 2)
+            return;
+        auto ret = Return::Cast(bb->last());
+        auto call = StaticCall::Cast(*(bb->end() - 2));
+        if (!ret || !call || ret->arg(0).val() != call ||
+            call->tryDispatch() != cls ||
+            call->runtimeClosure() != Tombstone::closure() ||
+            call->nCallArgs() != cls->owner()->nargs())
+            return;
+        for (size_t i = 0; i < call->nCallArgs(); ++i) {
+            auto v = call->callArg(i).val();
+            if (v == MissingArg::instance() || DotsList::Cast(v) ||
+                ExpandDots::Cast(v))
+                return;
+            auto ld = args.find(i);
+            if (ld != args.end() && !v->type.isA(ld->second->type))
+                return;
+        }
+        tails.push_back(bb);
+    });
+    if (tails.empty())
+        return false;
+
+    for (auto ld : duplicateArgs) {
+        ld->replaceUsesWith(args.at(ld->id));
+        ld->bb()->remove(ld);
+    }
+
+    // The old entry becomes the loop header, all arguments are loaded in a
+    // new entry block and merged with the arguments of the tail calls.
+    auto header = code->entry;
+    auto pre = new BB(code, code->nextBBId++);
+    code->entry = pre;
+    pre->setNext(header);
+
+    std::unordered_map<size_t, Phi*> phis;
+    for (auto& a : args) {
+        auto ld = a.second;
+        auto phi = new Phi;
+        phi->type = ld->type;
+        ld->replaceUsesWith(phi);
+        auto bb = ld->bb();
+        bb->moveToEnd(bb->atPosition(ld), pre);
+        phi->addInput(pre, ld);
+        header->insert(header->begin(), phi);
+        phis[a.first] = phi;
+    }
+
+    for (auto bb : tails) {
+        auto call = StaticCall::Cast(*(bb->end() - 2));
+        for (auto& p : phis)
+            p.second->addInput(bb, call->callArg(p.first).val());
+        bb->remove(bb->end() - 1);
+        bb->remove(bb->end() - 1);
+        bb->setNext(header);
+    }
+    return true;
+}
+
+} // namespace pir
+} // namespace rir
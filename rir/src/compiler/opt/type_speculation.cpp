@@ -24,10 +24,28 @@ bool TypeSpeculation::apply(Compiler&, ClosureVersion* cls, Code* code,
         BB*, std::unordered_map<Instruction*,
                                 std::pair<Checkpoint*, TypeTest::Info>>>
         speculate;
+    std::unordered_map<BB*,
+                       std::unordered_map<Instruction*,
+                                          std::pair<Checkpoint*, TypeFeedback>>>
+        speculateConstant;
 
     auto dom = DominanceGraph(code);
     VisitorNoDeoptBranch::run(code->entry, [&](Instruction* i) {
-        if (i->typeFeedback.used || i->typeFeedback.type.isVoid() ||
+        if (i->typeFeedback.used)
+            return;
+
+        // Values which always were the same scalar (e.g. flags like
+        // `drop = FALSE`) are replaced by the constant
+        if (i->typeFeedback.constant && !LdConst::Cast(i) &&
+            i->type.isRType() && !i->type.maybePromiseWrapped()) {
+            if (auto cp = checkpoint.next(i, i, dom)) {
+                speculateConstant[cp->nextBB()][i] = {cp, i->typeFeedback};
+                i->typeFeedback.used = true;
+                return;
+            }
+        }
+
+        if (i->typeFeedback.type.isVoid() ||
             i->type.isA(i->typeFeedback.type))
             return;
 
@@ -130,6 +148,34 @@ bool TypeSpeculation::apply(Compiler&, ClosureVersion* cls, Code* code,
             anyChange = true;
         }
     });
+
+    VisitorNoDeoptBranch::run(code->entry, [&](BB* bb) {
+        if (!speculateConstant.count(bb))
+            return;
+
+        for (auto sp : speculateConstant[bb]) {
+            auto i = sp.first;
+
+            auto ip = bb->begin();
+            if (i->bb() == bb)
+                ip = bb->atPosition(i) + 1;
+
+            auto cp = sp.second.first;
+            auto& feedback = sp.second.second;
+
+            auto expected = new LdConst(feedback.constant);
+            ip = bb->insert(ip, expected) + 1;
+            BBTransform::insertAssume(
+                new Identical(i, expected, PirType::any()), cp, bb, ip, true,
+                feedback.srcCode, feedback.origin);
+
+            // The guard itself has to keep using the original value
+            auto constant = new LdConst(feedback.constant);
+            bb->insert(ip, constant);
+            i->replaceDominatedUses(constant);
+            anyChange = true;
+        }
+    });
     return anyChange;
 }
 } // namespace pir
@@ -13,6 +13,18 @@ struct Parameter {
     static size_t MAX_INPUT_SIZE;
     static unsigned RIR_WARMUP;
     static unsigned DEOPT_ABANDON;
+    // Deopts of a single speculation, after which we stop speculating there.
+    // At most MaxSiteDeopts.
+    static unsigned DEOPT_SITE_ABANDON;
+    // Continue deopts in loops in optimized code, instead of the interpreter
+    static bool DEOPTLESS;
+    // Continuations compiled per guard
+    static unsigned DEOPTLESS_MAX_VERSIONS;
+    static unsigned RIR_DEQUICKEN_LIMIT;
+    static unsigned RIR_FEEDBACK_STABLE;
+    // Calls of a function between feedback windows, and calls per window
+    static unsigned RIR_FEEDBACK_EPOCH;
+    static unsigned RIR_FEEDBACK_WINDOW;
 
     static size_t PROMISE_INLINER_MAX_SIZE;
 
@@ -21,12 +33,17 @@ struct Parameter {
     static size_t INLINER_INITIAL_FUEL;
     static size_t INLINER_INLINE_UNLIKELY;
 
+    static size_t PIR_TRANSLATION_CACHE_SIZE;
+
     static bool RIR_PRESERVE;
     static unsigned RIR_SERIALIZE_CHAOS;
 
     static unsigned RIR_CHECK_PIR_TYPES;
 
     static unsigned PIR_LLVM_OPT_LEVEL;
+    static bool PIR_LLVM_LAZY_PROMISES;
+    static bool PIR_PERF_MAP;
+    static bool PIR_JITDUMP;
 
     static bool ENABLE_PIR2RIR;
 };
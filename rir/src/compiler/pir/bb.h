@@ -4,6 +4,7 @@
 #include "common.h"
 #include "pir.h"
 
+#include "compiler/util/node_pool.h"
 #include "utils/Set.h"
 #include <unordered_set>
 #include <iostream>
@@ -42,6 +43,11 @@ class BB {
     BB(Code* fun, unsigned id);
     ~BB();
 
+    static void* operator new(size_t size) { return NodePool::allocate(size); }
+    static void operator delete(void* p, size_t size) {
+        NodePool::release(p, size);
+    }
+
     static BB* cloneInstrs(BB* src, unsigned id, Code* target);
 
     void unsafeSetId(unsigned newId) { *const_cast<unsigned*>(&id) = newId; }
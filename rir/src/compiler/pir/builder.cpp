@@ -141,5 +141,15 @@ Builder::Builder(ClosureVersion* fun, Promise* prom)
     add(ldenv);
     this->env = ldenv;
 }
+
+Builder::Builder(ClosureVersion* fun)
+    : function(fun), code(fun), env(Env::frame()) {
+    createNextBB();
+    assert(!function->entry);
+    function->entry = bb;
+
+    // Create another BB to ensure that the entry BB has no predecessors.
+    createNextBB();
+}
 } // namespace pir
 } // namespace rir
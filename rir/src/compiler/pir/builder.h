@@ -27,6 +27,8 @@ class Builder {
 
     Builder(ClosureVersion* fun, Promise* prom);
     Builder(ClosureVersion* fun, Value* enclos);
+    // Continuations run in the existing environment of their frame
+    explicit Builder(ClosureVersion* fun);
 
     Value* buildDefaultEnv(ClosureVersion* fun);
 
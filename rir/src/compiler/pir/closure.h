@@ -58,6 +58,7 @@ class Closure {
     bool hasOriginClosure() const { return origin_; }
 
     rir::Function* rirFunction() const { return function; }
+    const Context& userContext() const { return userContext_; }
     SEXP srcRef() { return srcRef_; }
     Env* closureEnv() const { return env; }
     const std::string& name() const { return name_; }
@@ -117,11 +117,16 @@ size_t ClosureVersion::effectiveNArgs() const {
     return owner_->nargs() - optimizationContext_.numMissing();
 }
 
+static size_t revisions = 0;
+
+void ClosureVersion::changed() { revision_ = ++revisions; }
+
 ClosureVersion::ClosureVersion(Closure* closure, rir::Function* optFunction,
                                const Context& optimizationContext,
                                const Properties& properties)
     : optFunction(optFunction), owner_(closure),
       optimizationContext_(optimizationContext), properties(properties) {
+    changed();
     auto id = std::stringstream();
     id << closure->name() << "[" << this << "]";
     name_ = id.str();
@@ -48,6 +48,7 @@ class ClosureVersion : public Code {
 
     std::string name_;
     std::string nameSuffix_;
+    size_t revision_;
     ClosureVersion(Closure* closure, rir::Function* optFunction,
                    const Context& optimizationContext,
                    const Properties& properties = Properties());
@@ -59,6 +60,11 @@ class ClosureVersion : public Code {
 
     const Context& context() const { return optimizationContext_; }
 
+    // Unique over all versions, renewed whenever a pass changes this version.
+    // Allows analyses to cache results per version.
+    size_t revision() const { return revision_; }
+    void changed();
+
     Properties properties;
 
     Closure* owner() const { return owner_; }
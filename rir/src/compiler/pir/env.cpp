@@ -17,6 +17,9 @@ void Env::printRef(std::ostream& out) const {
     } else if (this == nil()) {
         out << "nil";
         return;
+    } else if (this == frame()) {
+        out << "frame";
+        return;
     }
 
     assert(rho);
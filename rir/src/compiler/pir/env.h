@@ -46,6 +46,14 @@ class Env : public Value {
         return &u;
     }
 
+    // The existing environment of the frame resumed by a continuation (see
+    // Deoptless). It is only known at runtime and passed in like the
+    // environment of a promise.
+    static Env* frame() {
+        static Env u(nullptr, nullptr);
+        return &u;
+    }
+
     void printRef(std::ostream& out) const override final;
 
     static Env* Cast(Value* v) {
@@ -497,6 +497,7 @@ bool Instruction::envOnlyForObj() {
     case Tag::Subassign1_2D:
     case Tag::Subassign2_2D:
     case Tag::Subassign1_3D:
+    case Tag::Append:
     case Tag::Not:
     case Tag::LOr:
     case Tag::LAnd:
@@ -2,6 +2,7 @@
 #define COMPILER_INSTRUCTION_H
 
 #include "R/r.h"
+#include "compiler/util/node_pool.h"
 #include "env.h"
 #include "instruction_list.h"
 #include "ir/BC_inc.h"
@@ -10,6 +11,7 @@
 #include "runtime/ArglistOrder.h"
 #include "singleton_values.h"
 #include "tag.h"
+#include "utils/SmallVector.h"
 #include "value.h"
 
 #include <algorithm>
@@ -143,6 +145,7 @@ enum class VisibilityFlag : uint8_t {
 struct TypeFeedback {
     PirType type = PirType::optimistic();
     Value* value = nullptr;
+    SEXP constant = nullptr;
     rir::Code* srcCode = nullptr;
     Opcode* origin = nullptr;
     bool used = false;
@@ -269,6 +272,11 @@ class Instruction : public Value {
 
     virtual ~Instruction() {}
 
+    static void* operator new(size_t size) { return NodePool::allocate(size); }
+    static void operator delete(void* p, size_t size) {
+        NodePool::release(p, size);
+    }
+
     InstructionUID id() const;
 
     virtual std::string name() const { return tagToStr(tag); }
@@ -695,15 +703,19 @@ class FixedLenInstructionWithEnvSlot
     };
 };
 
+// Most variable length instructions have only a few arguments, those are
+// stored inline.
+typedef SmallVector<InstrArg, 4> VarLenArgs;
+
 template <Tag ITAG, class Base, Effects::StoreType INITIAL_EFFECT,
           HasEnvSlot ENV, Controlflow CF = Controlflow::None>
 class VarLenInstruction
     : public InstructionImplementation<ITAG, Base, INITIAL_EFFECT, ENV, CF,
-                                       std::vector<InstrArg>> {
+                                       VarLenArgs> {
 
   public:
     typedef InstructionImplementation<ITAG, Base, INITIAL_EFFECT, ENV, CF,
-                                      std::vector<InstrArg>>
+                                      VarLenArgs>
         Super;
     using Super::arg;
     using Super::args_;
@@ -1505,6 +1517,30 @@ class FLIE(Subassign1_3D, 6, Effects::Any()) {
     }
 };
 
+// x <- c(x, val), like the subassigns this overrides vector if it is not
+// shared.
+class FLIE(Append, 3, Effects::Any()) {
+  public:
+    Append(Value* val, Value* vec, Value* env, unsigned srcIdx)
+        : FixedLenInstructionWithEnvSlot(PirType::valOrLazy(),
+                                         {{PirType::val(), PirType::val()}},
+                                         {{val, vec}}, env, srcIdx) {}
+    Value* val() const { return arg(0).val(); }
+    Value* vector() const { return arg(1).val(); }
+
+    PirType inferType(const GetType& getType) const override final {
+        auto merged =
+            getType(vector()).mergeWithConversion(getType(val())).orNotScalar();
+        // c of anything but vectors creates a list
+        if (!merged.isA((PirType::vecs() | RType::nil).orAttribs()))
+            merged = merged | RType::vec;
+        return ifNonObjectArgs(getType, type & merged, type);
+    }
+    Effects inferEffects(const GetType& getType) const override final {
+        return ifNonObjectArgs(getType, effects & errorWarnVisible, effects);
+    }
+};
+
 class FLIE(Extract1_1D, 3, Effects::Any()) {
   public:
     Extract1_1D(Value* vec, Value* idx, Value* env, unsigned srcIdx)
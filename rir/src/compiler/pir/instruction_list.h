@@ -33,7 +33,8 @@
     V(Subassign2_1D)                                                           \
     V(Subassign1_2D)                                                           \
     V(Subassign2_2D)                                                           \
-    V(Subassign1_3D)
+    V(Subassign1_3D)                                                           \
+    V(Append)
 
 #define COMPILER_INSTRUCTIONS(V)                                               \
     SIMPLE_INSTRUCTIONS(V_SIMPLE_INSTRUCTION_IN_COMPILER_INSTRUCTIONS, V)      \
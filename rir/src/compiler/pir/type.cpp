@@ -179,7 +179,8 @@ void PirType::merge(const ObservedValues& other) {
             flags_.set(TypeFlags::maybeAttrib);
         if (!record.scalar)
             flags_.set(TypeFlags::maybeNotScalar);
-        flags_.set(TypeFlags::maybeNAOrNaN);
+        if (!other.notNA)
+            flags_.set(TypeFlags::maybeNAOrNaN);
 
         merge(record.sexptype);
     }
@@ -238,6 +239,11 @@ void PirType::fromContext(const Context& assumptions, unsigned arg,
             type.setScalar(RType::integer);
             type.setNoAttribs();
         }
+        if (assumptions.isSimpleLgl(i)) {
+            type.setNotMissing();
+            type.setScalar(RType::logical);
+            type.setNoAttribs();
+        }
     }
 }
 }
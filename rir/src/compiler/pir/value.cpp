@@ -42,6 +42,8 @@ void Value::callArgTypeToContext(Context& assumptions, unsigned i) const {
                     assumptions.setSimpleReal(i);
                 if (value->type.isRType(RType::integer))
                     assumptions.setSimpleInt(i);
+                if (value->type.isRType(RType::logical))
+                    assumptions.setSimpleLgl(i);
             }
         }
     }
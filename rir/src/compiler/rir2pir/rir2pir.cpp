@@ -6,8 +6,10 @@
 #include "compiler/analysis/cfg.h"
 #include "compiler/analysis/query.h"
 #include "compiler/analysis/verifier.h"
+#include "compiler/parameter.h"
 #include "compiler/pir/builder.h"
 #include "compiler/pir/pir_impl.h"
+#include "compiler/util/apply_intrinsics.h"
 #include "compiler/util/arg_match.h"
 #include "compiler/util/visitor.h"
 #include "insert_cast.h"
@@ -99,9 +101,9 @@ void State::mergeIn(const State& incom, BB* incomBB) {
     incomBB->setNext(entryBB);
 }
 
-std::unordered_set<Opcode*> findMergepoints(rir::Code* srcCode) {
+std::unordered_set<Opcode*> findMergepoints(rir::Code* srcCode,
+                                            Opcode* first) {
     std::unordered_map<Opcode*, std::vector<Opcode*>> incom;
-    Opcode* first = srcCode->code();
 
     // Mark incoming jmps
     for (auto pc = srcCode->code(); pc != srcCode->endCode();) {
@@ -132,6 +134,12 @@ std::unordered_set<Opcode*> findMergepoints(rir::Code* srcCode) {
     return mergepoints;
 }
 
+// Speculating on this feedback caused too many deopts already
+template <typename Feedback>
+bool gaveUpOn(const Feedback& feedback) {
+    return (unsigned)feedback.deopts >= Parameter::DEOPT_SITE_ABANDON;
+}
+
 } // namespace
 
 namespace rir {
@@ -147,6 +155,22 @@ Rir2Pir::Rir2Pir(Compiler& cmp, ClosureVersion* cls, ClosureStreamLogger& log,
             cls->optFunction->body()->pirTypeFeedback());
 }
 
+// A function literal, or an argument statically known to be a closure
+static bool isKnownClosure(Value* arg) {
+    if (auto mk = MkArg::Cast(arg)) {
+        if (!mk->isEager()) {
+            auto ast = src_pool_at(globalContext(), mk->prom()->srcPoolIdx());
+            return TYPEOF(ast) == LANGSXP && CAR(ast) == symbol::Function;
+        }
+        arg = mk->eagerArg();
+    }
+    if (MkFunCls::Cast(arg))
+        return true;
+    if (auto con = LdConst::Cast(arg))
+        return TYPEOF(con->c()) == CLOSXP;
+    return false;
+}
+
 Checkpoint* Rir2Pir::addCheckpoint(rir::Code* srcCode, Opcode* pos,
                                    const RirStack& stack,
                                    Builder& insert) const {
@@ -211,7 +235,7 @@ bool Rir2Pir::compileBC(const BC& bc, Opcode* pos, Opcode* nextPos,
         }
     };
 
-    switch (bc.bc) {
+    switch (BC::dequicken(bc.bc)) {
 
     case Opcode::push_: {
         auto c = bc.immediateConst();
@@ -349,8 +373,8 @@ bool Rir2Pir::compileBC(const BC& bc, Opcode* pos, Opcode* nextPos,
 
     case Opcode::record_test_: {
         auto feedback = bc.immediate.testFeedback;
-        if (feedback.seen == ObservedTest::OnlyTrue ||
-            feedback.seen == ObservedTest::OnlyFalse) {
+        if (!gaveUpOn(feedback) && (feedback.seen == ObservedTest::OnlyTrue ||
+                                    feedback.seen == ObservedTest::OnlyFalse)) {
             if (auto i = Instruction::Cast(at(0))) {
                 auto v = feedback.seen == ObservedTest::OnlyTrue
                              ? (Value*)True::instance()
@@ -368,7 +392,8 @@ bool Rir2Pir::compileBC(const BC& bc, Opcode* pos, Opcode* nextPos,
     }
 
     case Opcode::record_type_: {
-        if (bc.immediate.typeFeedback.numTypes) {
+        if (bc.immediate.typeFeedback.numTypes &&
+            !gaveUpOn(bc.immediate.typeFeedback)) {
             auto feedback = bc.immediate.typeFeedback;
             if (auto i = Instruction::Cast(at(0))) {
                 // Search for the most specific feedabck for this location
@@ -387,6 +412,13 @@ bool Rir2Pir::compileBC(const BC& bc, Opcode* pos, Opcode* nextPos,
                         break;
                 }
                 // TODO: deal with multiple locations
+                auto constant = feedback.monomorphicConstant
+                                    ? feedback.constant(srcCode)
+                                    : nullptr;
+                if (i->typeFeedback.type.isVoid())
+                    i->typeFeedback.constant = constant;
+                else if (i->typeFeedback.constant != constant)
+                    i->typeFeedback.constant = nullptr;
                 i->typeFeedback.type.merge(feedback);
                 i->typeFeedback.srcCode = srcCode;
                 i->typeFeedback.origin = pos;
@@ -403,6 +435,8 @@ bool Rir2Pir::compileBC(const BC& bc, Opcode* pos, Opcode* nextPos,
         Value* target = top();
 
         auto feedback = bc.immediate.callFeedback;
+        if (gaveUpOn(feedback))
+            break;
 
         // If this call was never executed. Might as well compile an
         // unconditional deopt.
@@ -427,7 +461,7 @@ bool Rir2Pir::compileBC(const BC& bc, Opcode* pos, Opcode* nextPos,
     case Opcode::mk_eager_promise_:
     case Opcode::mk_promise_: {
         unsigned promi = bc.immediate.i;
-        rir::Code* promiseCode = srcCode->getPromise(promi);
+        rir::Code* promiseCode = srcCode->getPromise(promi)->materialized();
         Value* val = UnboundValue::instance();
         if (bc.bc == Opcode::mk_eager_promise_)
             val = pop();
@@ -706,6 +740,17 @@ bool Rir2Pir::compileBC(const BC& bc, Opcode* pos, Opcode* nextPos,
             missingArgs = needed - matchedArgs.size();
         }
 
+        // Calls to the apply family with a known function argument go to a
+        // replacement closure, where the calls to the function argument are
+        // visible to PIR. The guard above still checks for the base function.
+        if (monomorphicClosure) {
+            if (auto intrinsic = ApplyIntrinsics::find(monomorphic)) {
+                if (intrinsic->funArg < matchedArgs.size() &&
+                    isKnownClosure(matchedArgs[intrinsic->funArg]))
+                    monomorphic = intrinsic->replacement;
+            }
+        }
+
         // Emit the actual call
         auto ast = bc.immediate.callFixedArgs.ast;
         auto insertGenericCall = [&]() {
@@ -924,6 +969,15 @@ bool Rir2Pir::compileBC(const BC& bc, Opcode* pos, Opcode* nextPos,
         break;
     }
 
+    case Opcode::append_: {
+        forceIfPromised(1);
+        addCheckpoint(srcCode, pos, stack, insert);
+        Value* val = pop();
+        Value* vec = pop();
+        push(insert(new Append(val, vec, env, srcIdx)));
+        break;
+    }
+
 #define BINOP_NOENV(Name, Op)                                                  \
     case Opcode::Op: {                                                         \
         auto rhs = pop();                                                      \
@@ -1099,6 +1153,11 @@ bool Rir2Pir::compileBC(const BC& bc, Opcode* pos, Opcode* nextPos,
     case Opcode::invalid_:
     case Opcode::num_of:
 
+    // Quickened opcodes are translated as their generic version:
+#define V(NESTED, op, lhs, rhs) case Opcode::op##_##lhs##_##rhs##_:
+        BC_QUICKENED(V, _)
+#undef V
+
     // Opcodes handled elsewhere
     case Opcode::brtrue_:
     case Opcode::brfalse_:
@@ -1137,6 +1196,16 @@ bool Rir2Pir::tryCompile(rir::Code* srcCode, Builder& insert) {
     return false;
 }
 
+bool Rir2Pir::tryCompileContinuation(Builder& insert, Opcode* pc,
+                                     const std::vector<PirType>& stack) {
+    auto srcCode = cls->owner()->rirFunction()->body();
+    if (auto res = tryTranslate(srcCode, insert, pc, stack)) {
+        finalize(res, insert);
+        return true;
+    }
+    return false;
+}
+
 bool Rir2Pir::tryCompilePromise(rir::Code* prom, Builder& insert) {
     return PromiseRir2Pir(compiler, cls, log, name, outerFeedback, false)
         .tryCompile(prom, insert);
@@ -1148,21 +1217,32 @@ Value* Rir2Pir::tryInlinePromise(rir::Code* srcCode, Builder& insert) {
 }
 
 Value* Rir2Pir::tryTranslate(rir::Code* srcCode, Builder& insert) {
+    return tryTranslate(srcCode, insert, srcCode->code(), {});
+}
+
+Value* Rir2Pir::tryTranslate(rir::Code* srcCode, Builder& insert,
+                             Opcode* start,
+                             const std::vector<PirType>& initialStack) {
     assert(!finalized);
 
     CallTargetFeedback callTargetFeedback;
     std::vector<ReturnSite> results;
 
     std::unordered_map<Opcode*, State> mergepoints;
-    for (auto p : findMergepoints(srcCode))
+    for (auto p : findMergepoints(srcCode, start))
         mergepoints.emplace(p, State());
 
     std::deque<State> worklist;
     State cur;
     cur.seen = true;
+    for (size_t i = 0; i < initialStack.size(); ++i) {
+        auto ld = insert(new LdArg(i));
+        ld->type = initialStack[i];
+        cur.stack.push(ld);
+    }
 
     Opcode* end = srcCode->endCode();
-    Opcode* finger = srcCode->code();
+    Opcode* finger = start;
 
     auto popWorklist = [&]() {
         assert(!worklist.empty());
@@ -6,6 +6,7 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace rir {
 namespace pir {
@@ -21,6 +22,12 @@ class Rir2Pir {
 
     bool tryCompile(Builder& insert) __attribute__((warn_unused_result));
 
+    // Translates the body starting at pc, where the rir stack holds values of
+    // the given types. They are passed in as arguments.
+    bool tryCompileContinuation(Builder& insert, Opcode* pc,
+                                const std::vector<PirType>& stack)
+        __attribute__((warn_unused_result));
+
     Value* tryCreateArg(rir::Code* prom, Builder& insert, bool eager)
         __attribute__((warn_unused_result));
 
@@ -37,6 +44,9 @@ class Rir2Pir {
 
     Value* tryTranslate(rir::Code* srcCode, Builder& insert)
         __attribute__((warn_unused_result));
+    Value* tryTranslate(rir::Code* srcCode, Builder& insert, Opcode* start,
+                        const std::vector<PirType>& initialStack)
+        __attribute__((warn_unused_result));
 
     void finalize(Value*, Builder& insert);
 
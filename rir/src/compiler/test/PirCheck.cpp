@@ -83,6 +83,17 @@ static bool testNoEnvSpec(ClosureVersion* f) { return Query::noEnvSpec(f); }
 
 static bool testNoEnv(ClosureVersion* f) { return Query::noEnv(f); }
 
+static bool testMkEnvOnlyInDeopt(ClosureVersion* f) {
+    bool found = false;
+    bool success = Visitor::check(f->entry, [&](Instruction* i) {
+        if (!MkEnv::Cast(i))
+            return true;
+        found = true;
+        return i->bb()->isDeopt();
+    });
+    return found && success;
+}
+
 static bool testNoPromise(ClosureVersion* f) {
     return VisitorNoDeoptBranch::check(
         f->entry, [&](Instruction* i) { return !MkArg::Cast(i); });
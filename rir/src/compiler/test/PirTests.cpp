@@ -11,6 +11,7 @@
 #include "compiler/analysis/cfg.h"
 #include "compiler/compiler.h"
 #include "compiler/parameter.h"
+#include "utils/SmallVector.h"
 #include <string>
 #include <vector>
 
@@ -890,6 +891,23 @@ bool testTypeRules() {
     return true;
 }
 
+bool testSmallVector() {
+    SmallVector<int, 2> v;
+    v.push_back(1);
+    // Like VarLenInstructionWithEnvSlot::pushArg, the pushed element is in
+    // the vector itself. It grows from inline to the heap and then on the
+    // heap.
+    for (int i = 0; i < 20; ++i) {
+        v.push_back(v.back());
+        v[v.size() - 2] = i;
+    }
+    assert(v.size() == 21);
+    for (int i = 0; i < 20; ++i)
+        assert(v[i] == i);
+    assert(v.back() == 1);
+    return true;
+}
+
 static Test tests[] = {
     Test("test cfg", &testCfg),
     Test("test_42L", []() { return test42("42L"); }),
@@ -1062,7 +1080,8 @@ static Test tests[] = {
              return test42("{a<- 41L; b<- 1L; f <- function(x,y) x+y; f(a,b)}");
          }),
     Test("Test dead store analysis", &testDeadStore),
-    Test("Test type rules", &testTypeRules)};
+    Test("Test type rules", &testTypeRules),
+    Test("Test SmallVector", &testSmallVector)};
 } // namespace
 
 namespace rir {
@@ -0,0 +1,178 @@
+#include "apply_intrinsics.h"
+
+#include "R/Protect.h"
+#include "R_ext/Parse.h"
+#include "ir/Compiler.h"
+
+#include <vector>
+
+namespace rir {
+namespace pir {
+
+// The replacements are closed over the base namespace, thus the fallbacks
+// call the original functions. Like the C implementations, they force the
+// elements before the call (forceAndCall), closures capturing an element must
+// not see a later one.
+static const struct {
+    const char* name;
+    size_t funArg;
+    const char* source;
+} definitions[] = {
+    {"lapply", 1, R"(
+function(X, FUN, ...) {
+    if (!is.function(FUN) || !is.vector(X) || is.object(X))
+        return(lapply(X, FUN, ...))
+    n <- length(X)
+    ans <- vector("list", n)
+    for (i in seq_len(n))
+        ans[i] <- list(forceAndCall(1, FUN, X[[i]], ...))
+    names(ans) <- names(X)
+    ans
+})"},
+    {"vapply", 1, R"(
+function(X, FUN, FUN.VALUE, ..., USE.NAMES = TRUE) {
+    if (!is.function(FUN) || !is.vector(X) || is.object(X) ||
+        !is.atomic(FUN.VALUE) || length(FUN.VALUE) != 1L ||
+        !is.null(attributes(FUN.VALUE)))
+        return(vapply(X, FUN, FUN.VALUE, ..., USE.NAMES = USE.NAMES))
+    type <- typeof(FUN.VALUE)
+    n <- length(X)
+    ans <- vector(type, n)
+    for (i in seq_len(n)) {
+        v <- forceAndCall(1, FUN, X[[i]], ...)
+        if (length(v) != 1L)
+            stop(gettextf(
+                "values must be length 1,\n but FUN(X[[%d]]) result is length %d",
+                i, length(v)))
+        t <- typeof(v)
+        if (t != type &&
+            !(type == "double" && (t == "integer" || t == "logical")) &&
+            !(type == "integer" && t == "logical"))
+            stop(gettextf(
+                "values must be type '%s',\n but FUN(X[[%d]]) result is type '%s'",
+                type, i, t))
+        ans[[i]] <- v
+    }
+    if (USE.NAMES) {
+        if (is.character(X) && is.null(names(X)))
+            names(ans) <- X
+        else
+            names(ans) <- names(X)
+    }
+    ans
+})"},
+    {"sapply", 1, R"(
+function(X, FUN, ..., simplify = TRUE, USE.NAMES = TRUE) {
+    if (!is.function(FUN) || !is.vector(X) || is.object(X))
+        return(sapply(X, FUN, ..., simplify = simplify, USE.NAMES = USE.NAMES))
+    n <- length(X)
+    answer <- vector("list", n)
+    for (i in seq_len(n))
+        answer[i] <- list(forceAndCall(1, FUN, X[[i]], ...))
+    names(answer) <- names(X)
+    if (USE.NAMES && is.character(X) && is.null(names(answer)))
+        names(answer) <- X
+    if (!isFALSE(simplify) && length(answer))
+        simplify2array(answer, higher = (simplify == "array"))
+    else answer
+})"},
+    {"Map", 0, R"(
+function(f, ...) {
+    args <- list(...)
+    if (!is.function(f) || length(args) < 1L || length(args) > 2L ||
+        !is.null(names(args)))
+        return(Map(f, ...))
+    x <- args[[1L]]
+    y <- args[[length(args)]]
+    if (!is.vector(x) || is.object(x) || !is.vector(y) || is.object(y) ||
+        length(x) != length(y))
+        return(Map(f, ...))
+    n <- length(x)
+    ans <- vector("list", n)
+    if (length(args) == 1L) {
+        for (i in seq_len(n))
+            ans[i] <- list(forceAndCall(1, f, x[[i]]))
+    } else {
+        for (i in seq_len(n))
+            ans[i] <- list(forceAndCall(2, f, x[[i]], y[[i]]))
+    }
+    if (!is.null(names(x)))
+        names(ans) <- names(x)
+    else if (is.character(x))
+        names(ans) <- x
+    ans
+})"},
+    {"Reduce", 0, R"(
+function(f, x, init, right = FALSE, accumulate = FALSE) {
+    if (!is.function(f) || !isFALSE(accumulate) || !is.vector(x) ||
+        is.object(x))
+        return(Reduce(f, x, init, right, accumulate))
+    mis <- missing(init)
+    len <- length(x)
+    if (len == 0L)
+        return(if (mis) NULL else init)
+    if (right) {
+        i <- len
+        if (mis) {
+            init <- x[[len]]
+            i <- len - 1L
+        }
+        while (i >= 1L) {
+            init <- forceAndCall(2, f, x[[i]], init)
+            i <- i - 1L
+        }
+    } else {
+        i <- 1L
+        if (mis) {
+            init <- x[[1L]]
+            i <- 2L
+        }
+        while (i <= len) {
+            init <- forceAndCall(2, f, init, x[[i]])
+            i <- i + 1L
+        }
+    }
+    init
+})"},
+};
+
+static std::vector<ApplyIntrinsics::Intrinsic> intrinsics;
+
+void ApplyIntrinsics::initialize() {
+    assert(intrinsics.empty());
+    Protect p;
+    for (auto& d : definitions) {
+        SEXP original = Rf_findVarInFrame(R_BaseNamespace, Rf_install(d.name));
+        // Base functions are lazy loaded
+        if (TYPEOF(original) == PROMSXP)
+            original = p(Rf_eval(original, R_BaseNamespace));
+        if (TYPEOF(original) != CLOSXP)
+            continue;
+
+        ParseStatus status;
+        SEXP src = p(Rf_mkString(d.source));
+        SEXP exp = p(R_ParseVector(src, -1, &status, R_NilValue));
+        assert(status == PARSE_OK && "invalid apply intrinsic");
+        SEXP replacement = p(Rf_eval(VECTOR_ELT(exp, 0), R_BaseNamespace));
+
+        // The replacement is only sound if the arguments are matched the same
+        // way, which might not be the case for other versions of GNU R.
+        if (!R_compute_identical(FORMALS(original), FORMALS(replacement), 16))
+            continue;
+
+        Compiler::compileClosure(replacement);
+        R_PreserveObject(original);
+        R_PreserveObject(replacement);
+        intrinsics.push_back({original, replacement, d.funArg});
+    }
+}
+
+const ApplyIntrinsics::Intrinsic* ApplyIntrinsics::find(SEXP closure) {
+    for (auto& i : intrinsics)
+        if (i.original == closure)
+            return &i;
+    return nullptr;
+}
+
+} // namespace pir
+} // namespace rir
@@ -0,0 +1,37 @@
+#ifndef APPLY_INTRINSICS_H
+#define APPLY_INTRINSICS_H
+
+#include "R/r.h"
+
+#include <cstddef>
+
+namespace rir {
+namespace pir {
+
+/*
+ * The apply family (lapply, vapply, sapply, Map and Reduce) calls back into
+ * the function argument from C, thus PIR cannot see the calls. For each of
+ * them we keep a replacement closure with the same formals, where the
+ * function argument is called from a plain R loop. Anything but the common
+ * case falls back to the original base function.
+ */
+class ApplyIntrinsics {
+  public:
+    struct Intrinsic {
+        SEXP original;
+        SEXP replacement;
+        // Position of the function argument in the formals
+        size_t funArg;
+    };
+
+    // Creates the replacements, called once when the runtime is initialized
+    static void initialize();
+
+    // Returns the intrinsic for a base apply closure, or nullptr
+    static const Intrinsic* find(SEXP closure);
+};
+
+} // namespace pir
+} // namespace rir
+
+#endif
@@ -186,7 +186,10 @@ BB* BBTransform::lowerExpect(Code* code, BB* src, BB::Instrs::iterator position,
                 if (LdConst::Cast(src))
                     src = t->arg<1>().val();
                 assert(!LdConst::Cast(src));
-                r = DeoptReason::Calltarget;
+                // Either a guarded call target or a speculated constant
+                r = *origin.second == Opcode::record_type_
+                        ? DeoptReason::Typecheck
+                        : DeoptReason::Calltarget;
             } else if (auto t = IsEnvStub::Cast(cond)) {
                 src = t->arg(0).val();
                 r = DeoptReason::EnvStubMaterialized;
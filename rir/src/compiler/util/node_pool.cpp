@@ -0,0 +1,59 @@
+#include "node_pool.h"
+
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+namespace rir {
+namespace pir {
+
+static constexpr size_t GRANULE = 16;
+static constexpr size_t SIZE_CLASSES = 32;
+static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+struct FreeNode {
+    FreeNode* next;
+};
+
+static FreeNode* freeLists[SIZE_CLASSES];
+static uint8_t* chunkPos = nullptr;
+static uint8_t* chunkEnd = nullptr;
+
+static size_t sizeClass(size_t size) { return (size + GRANULE - 1) / GRANULE; }
+
+void* NodePool::allocate(size_t size) {
+    auto c = sizeClass(size);
+    if (c >= SIZE_CLASSES)
+        return ::operator new(size);
+
+    if (auto node = freeLists[c]) {
+        freeLists[c] = node->next;
+        return node;
+    }
+
+    size_t bytes = c * GRANULE;
+    if (!chunkPos || chunkPos + bytes > chunkEnd) {
+        // The tail of the old chunk is wasted, it is at most one node
+        chunkPos = static_cast<uint8_t*>(::operator new(CHUNK_SIZE));
+        chunkEnd = chunkPos + CHUNK_SIZE;
+    }
+    auto node = chunkPos;
+    chunkPos += bytes;
+    return node;
+}
+
+void NodePool::release(void* node, size_t size) {
+    if (!node)
+        return;
+    auto c = sizeClass(size);
+    if (c >= SIZE_CLASSES) {
+        ::operator delete(node);
+        return;
+    }
+    auto n = static_cast<FreeNode*>(node);
+    n->next = freeLists[c];
+    freeLists[c] = n;
+}
+
+} // namespace pir
+} // namespace rir
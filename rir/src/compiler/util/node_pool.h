@@ -0,0 +1,28 @@
+#ifndef PIR_NODE_POOL_H
+#define PIR_NODE_POOL_H
+
+#include <cstddef>
+
+namespace rir {
+namespace pir {
+
+/*
+ * Allocator for the nodes of the PIR graph (instructions and basic blocks).
+ *
+ * Nodes are created and deleted by the thousands during every compilation,
+ * most of them from a handful of sizes. The pool hands them out of large
+ * chunks by bumping a pointer and keeps one free list per size class, such
+ * that deleted nodes are reused by the next compilation instead of going
+ * through malloc. Chunks are never given back. The free lists are not
+ * locked, PIR only compiles on the R thread.
+ */
+class NodePool {
+  public:
+    static void* allocate(size_t size);
+    static void release(void* node, size_t size);
+};
+
+} // namespace pir
+} // namespace rir
+
+#endif
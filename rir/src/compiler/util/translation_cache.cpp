@@ -0,0 +1,167 @@
+#include "translation_cache.h"
+
+#include "bb_transform.h"
+#include "compiler/parameter.h"
+#include "compiler/pir/pir_impl.h"
+#include "runtime_stats.h"
+#include "visitor.h"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <tuple>
+
+namespace rir {
+namespace pir {
+
+size_t Parameter::PIR_TRANSLATION_CACHE_SIZE =
+    getenv("PIR_TRANSLATION_CACHE_SIZE")
+        ? atoi(getenv("PIR_TRANSLATION_CACHE_SIZE"))
+        : 128;
+
+typedef std::tuple<rir::Function*, SEXP, Context> Key;
+
+struct Entry {
+    // Owns the closure of the cached version and the envs it refers to
+    std::unique_ptr<Module> module;
+    ClosureVersion* version;
+    // Keeps the source function and its environment alive
+    SEXP origin;
+    unsigned epoch;
+    std::list<Key>::iterator age;
+};
+
+static std::map<Key, Entry>& entries() {
+    static std::map<Key, Entry> entries;
+    return entries;
+}
+
+static std::list<Key>& order() {
+    static std::list<Key> order;
+    return order;
+}
+
+static Key key(Closure* closure, const Context& ctx) {
+    return Key(closure->rirFunction(), closure->closureEnv()->rho, ctx);
+}
+
+static unsigned feedbackEpoch(rir::Code* code) {
+    auto epoch = code->feedbackEpoch;
+    for (unsigned i = 0; i < code->extraPoolSize; ++i)
+        if (auto p = rir::Code::check(code->getExtraPoolEntry(i)))
+            epoch += feedbackEpoch(p);
+    return epoch;
+}
+
+static unsigned feedbackEpoch(rir::Function* fun) {
+    auto epoch = feedbackEpoch(fun->body());
+    for (size_t i = 0; i < fun->nargs(); ++i)
+        if (auto arg = fun->defaultArg(i))
+            epoch += feedbackEpoch(arg);
+    return epoch;
+}
+
+// Envs are owned by the module, thus every copy needs to point to the ones of
+// the module it lives in.
+static void relocateEnvs(ClosureVersion* version, Module* module) {
+    auto relocate = [&](Code* code) {
+        Visitor::run(code->entry, [&](Instruction* i) {
+            i->eachArg([&](InstrArg& arg) {
+                if (Env::isStaticEnv(arg.val()) && arg.val() != Env::global())
+                    arg.val() = module->getEnv(Env::Cast(arg.val())->rho);
+            });
+        });
+    };
+    relocate(version);
+    version->eachPromise([&](Promise* p) { relocate(p); });
+}
+
+// Only leaf versions can be copied between modules, other closures are not
+// referenced by the translation.
+static bool isLeaf(ClosureVersion* version) {
+    bool leaf = true;
+    auto check = [&](Code* code) {
+        Visitor::run(code->entry, [&](Instruction* i) {
+            if (StaticCall::Cast(i))
+                leaf = false;
+            if (auto mk = MkFunCls::Cast(i))
+                if (mk->cls)
+                    leaf = false;
+        });
+    };
+    check(version);
+    version->eachPromise([&](Promise* p) { check(p); });
+    return leaf;
+}
+
+static void evict(std::map<Key, Entry>::iterator e) {
+    R_ReleaseObject(e->second.origin);
+    order().erase(e->second.age);
+    entries().erase(e);
+}
+
+ClosureVersion* TranslationCache::get(Closure* closure, const Context& ctx,
+                                      rir::Function* optFunction,
+                                      Module* module) {
+    if (!Parameter::PIR_TRANSLATION_CACHE_SIZE)
+        return nullptr;
+
+    auto e = entries().find(key(closure, ctx));
+    if (e == entries().end())
+        return nullptr;
+    if (e->second.epoch != feedbackEpoch(closure->rirFunction())) {
+        evict(e);
+        return nullptr;
+    }
+
+    auto cached = e->second.version;
+    auto version = closure->declareVersion(ctx, optFunction);
+    version->properties = cached->properties;
+    version->entry = BBTransform::clone(cached->entry, version, version);
+    relocateEnvs(version, module);
+    RuntimeStats::count(RuntimeStats::TranslationCacheHits);
+    return version;
+}
+
+void TranslationCache::put(ClosureVersion* version) {
+    if (!Parameter::PIR_TRANSLATION_CACHE_SIZE || !isLeaf(version))
+        return;
+
+    auto closure = version->owner();
+    auto k = key(closure, version->context());
+    auto existing = entries().find(k);
+    if (existing != entries().end())
+        evict(existing);
+
+    auto module = new Module;
+    Closure* copy;
+    SEXP origin;
+    if (closure->hasOriginClosure()) {
+        origin = closure->rirClosure();
+        copy = module->getOrDeclareRirClosure(closure->name(), origin,
+                                              closure->rirFunction(),
+                                              closure->userContext());
+    } else {
+        origin = closure->rirFunction()->container();
+        copy = module->getOrDeclareRirFunction(
+            closure->name(), closure->rirFunction(),
+            closure->formals().original(), closure->srcRef(),
+            closure->userContext());
+    }
+    auto cached =
+        copy->declareVersion(version->context(), version->optFunction);
+    cached->properties = version->properties;
+    cached->entry = BBTransform::clone(version->entry, cached, cached);
+    relocateEnvs(cached, module);
+
+    R_PreserveObject(origin);
+    auto age = order().insert(order().end(), k);
+    entries().emplace(k, Entry{std::unique_ptr<Module>(module), cached, origin,
+                               feedbackEpoch(closure->rirFunction()), age});
+
+    while (entries().size() > Parameter::PIR_TRANSLATION_CACHE_SIZE)
+        evict(entries().find(order().front()));
+}
+
+} // namespace pir
+} // namespace rir
@@ -0,0 +1,33 @@
+#ifndef TRANSLATION_CACHE_H
+#define TRANSLATION_CACHE_H
+
+#include "compiler/pir/pir.h"
+#include "runtime/Context.h"
+
+namespace rir {
+namespace pir {
+
+class Module;
+
+/*
+ * Every compilation uses a fresh module, thus helpers which are called (and
+ * inlined) from many places are translated by rir2pir over and over again.
+ * This cache keeps a copy of the translated PIR of a closure per context,
+ * which outlives the module it was created in. Entries are dropped as soon as
+ * the feedback of the source function changes, or we deopt through it.
+ */
+class TranslationCache {
+  public:
+    // Declares a version of closure for ctx, filled with a cached translation.
+    // Returns nullptr if there is none.
+    static ClosureVersion* get(Closure* closure, const Context& ctx,
+                               rir::Function* optFunction, Module* module);
+
+    // Remembers a copy of a freshly translated version
+    static void put(ClosureVersion* version);
+};
+
+} // namespace pir
+} // namespace rir
+
+#endif
@@ -7,10 +7,13 @@
 #include "compiler/parameter.h"
 #include "event_counters.h"
 #include "ir/Deoptimization.h"
+#include "runtime/FeedbackWindow.h"
 #include "runtime/LazyArglist.h"
 #include "runtime/LazyEnvironment.h"
 #include "runtime/TypeFeedback_inl.h"
+#include "runtime_stats.h"
 #include "safe_force.h"
+#include "sampling_profiler.h"
 #include "utils/Pool.h"
 
 #include <assert.h>
@@ -171,6 +174,7 @@ SEXP evalRirCode(Code*, InterpreterInstance*, SEXP, const CallContext*, Opcode*,
                  BindingCache*);
 
 static RIR_INLINE SEXP createPromise(Code* code, SEXP env) {
+    RuntimeStats::count(RuntimeStats::PromiseAllocations);
     SEXP p = Rf_mkPROMISE(code->container(), env);
     return p;
 }
@@ -296,6 +300,7 @@ SEXP materialize(SEXP rirDataWrapper) {
             return environment;
         };
         auto newEnv = createEnvironment(globalContext(), rirDataWrapper);
+        RuntimeStats::count(RuntimeStats::EnvMaterializations);
         Rf_setAttrib(newEnv, symbol::delayedEnv, rirDataWrapper);
         lazyEnv->clear();
         RCNTXT* cur = (RCNTXT*)R_GlobalContext;
@@ -508,6 +513,9 @@ static RIR_INLINE SEXP rirCallTrampoline(const CallContext& call, Function* fun,
            fun->signature().envCreation ==
                FunctionSignature::Environment::CalleeCreated);
 
+    if (fun->body()->flags.contains(Code::NoContext) && !RDEBUG(call.callee))
+        return evalRirCode(fun->body(), ctx, env, &call);
+
     RCNTXT cntxt;
 
     // This code needs to be protected, because its slot in the dispatch table
@@ -555,23 +563,46 @@ void checkUserInterrupt() {
     if (++count > UI_COUNT_DELTA) {
         R_CheckUserInterrupt();
         R_RunPendingFinalizers();
+        RuntimeStats::tick();
         count = 0;
     }
 }
 
+// Set if the next deopt is caused by a speculation which the compiler can
+// turn off on its own, by not speculating on the feedback of its origin.
+static bool nextDeoptHasSite = false;
+
+bool deoptHasSite() {
+    auto res = nextDeoptHasSite;
+    nextDeoptHasSite = false;
+    return res;
+}
+
 void recordDeoptReason(SEXP val, const DeoptReason& reason) {
     Opcode* pos = (Opcode*)reason.srcCode + reason.originOffset;
+    reason.srcCode->rearmFeedback();
+    // Deopts of sites which were given up on already mean that something
+    // else is wrong, they count against the whole function.
+    auto recordSiteDeopt = [](auto feedback) {
+        nextDeoptHasSite =
+            (unsigned)feedback->deopts < pir::Parameter::DEOPT_SITE_ABANDON;
+        feedback->recordDeopt();
+    };
     switch (reason.reason) {
     case DeoptReason::DeadBranchReached: {
+        RuntimeStats::count(RuntimeStats::DeoptDeadBranchReached);
         assert(*pos == Opcode::record_test_);
         ObservedTest* feedback = (ObservedTest*)(pos + 1);
         feedback->seen = ObservedTest::Both;
+        recordSiteDeopt(feedback);
         break;
     }
     case DeoptReason::Typecheck: {
+        RuntimeStats::count(RuntimeStats::DeoptTypecheck);
         assert(*pos == Opcode::record_type_);
         ObservedValues* feedback = (ObservedValues*)(pos + 1);
-        feedback->record(val);
+        feedback->record(val, reason.srcCode);
+        recordSiteDeopt(feedback);
         if (TYPEOF(val) == PROMSXP) {
             if (PRVALUE(val) == R_UnboundValue &&
                 feedback->stateBeforeLastForce < ObservedValues::promise)
@@ -584,14 +615,19 @@ void recordDeoptReason(SEXP val, const DeoptReason& reason) {
         break;
     }
     case DeoptReason::Calltarget: {
+        RuntimeStats::count(RuntimeStats::DeoptCalltarget);
         assert(*pos == Opcode::record_call_);
         ObservedCallees* feedback = (ObservedCallees*)(pos + 1);
         feedback->record(reason.srcCode, val);
         assert(feedback->taken > 0);
+        recordSiteDeopt(feedback);
         break;
     }
     case DeoptReason::EnvStubMaterialized: {
+        RuntimeStats::count(RuntimeStats::DeoptEnvStubMaterialized);
+        // The next version will not elide this environment
         reason.srcCode->flags.set(Code::NeedsFullEnv);
+        nextDeoptHasSite = true;
         break;
     }
     case DeoptReason::None:
@@ -600,6 +636,19 @@ void recordDeoptReason(SEXP val, const DeoptReason& reason) {
     }
 }
 
+// Once none of the record_ instructions of a code object changed its feedback
+// for RIR_FEEDBACK_STABLE executions, we stop recording (0 means never). The
+// next deopt through this code object re-arms it.
+static RIR_INLINE void feedbackRecorded(Code* c, bool changed) {
+    if (changed) {
+        c->feedbackChanged();
+    } else if (pir::Parameter::RIR_FEEDBACK_STABLE &&
+               ++c->unchangedFeedbackCount >=
+                   pir::Parameter::RIR_FEEDBACK_STABLE) {
+        c->flags.set(Code::StableFeedback);
+    }
+}
+
 const static SEXP loopTrampolineMarker = (SEXP)0x7007;
 static void loopTrampoline(Code* c, InterpreterInstance* ctx, SEXP env,
                            const CallContext* callCtxt, Opcode* pc,
@@ -875,6 +924,8 @@ void inferCurrentContext(CallContext& call, size_t formalNargs,
                     given.setSimpleReal(i);
                 if (IS_SIMPLE_SCALAR(arg, INTSXP))
                     given.setSimpleInt(i);
+                if (IS_SIMPLE_SCALAR(arg, LGLSXP))
+                    given.setSimpleLgl(i);
             }
         }
     };
@@ -915,6 +966,14 @@ unsigned pir::Parameter::RIR_WARMUP =
     getenv("PIR_WARMUP") ? atoi(getenv("PIR_WARMUP")) : 3;
 unsigned pir::Parameter::DEOPT_ABANDON =
     getenv("PIR_DEOPT_ABANDON") ? atoi(getenv("PIR_DEOPT_ABANDON")) : 10;
+unsigned pir::Parameter::DEOPT_SITE_ABANDON =
+    getenv("PIR_DEOPT_SITE_ABANDON") ? atoi(getenv("PIR_DEOPT_SITE_ABANDON"))
+                                     : 2;
+unsigned pir::Parameter::RIR_DEQUICKEN_LIMIT =
+    getenv("RIR_DEQUICKEN_LIMIT") ? atoi(getenv("RIR_DEQUICKEN_LIMIT")) : 8;
+unsigned pir::Parameter::RIR_FEEDBACK_STABLE =
+    getenv("RIR_FEEDBACK_STABLE") ? atoi(getenv("RIR_FEEDBACK_STABLE"))
+                                  : 10000;
 
 static unsigned serializeCounter = 0;
 
@@ -1016,6 +1075,8 @@ RIR_INLINE SEXP rirCall(CallContext& call, InterpreterInstance* ctx) {
                         ctx);
     Function* fun = dispatch(call, table);
     fun->registerInvocation();
+    if (fun == table->baseline() && table->size() > 1)
+        RuntimeStats::count(RuntimeStats::DispatchMisses);
 
     if (!isDeoptimizing() && RecompileHeuristic(table, fun)) {
         Context given = call.givenContext;
@@ -1033,6 +1094,9 @@ RIR_INLINE SEXP rirCall(CallContext& call, InterpreterInstance* ctx) {
             }
         }
     }
+    if (!isDeoptimizing())
+        fun = FeedbackWindow::dispatch(table, fun);
+
     bool needsEnv = fun->signature().envCreation ==
                     FunctionSignature::Environment::CallerProvided;
     LazyArglistOnStack lazyPromargs(
@@ -1120,6 +1184,7 @@ SEXP builtinCall(CallContext& call, InterpreterInstance* ctx) {
                 R_Visible = static_cast<Rboolean>(flag != 1);
             return res;
         }
+        RuntimeStats::count(RuntimeStats::BuiltinSlowcases);
 #ifdef DEBUG_SLOWCASES
         SLOWCASE_COUNTER.count("builtin", call, ctx);
 #endif
@@ -1133,6 +1198,7 @@ static RIR_INLINE SEXP specialCall(CallContext& call,
         SEXP res = tryFastSpecialCall(call, ctx);
         if (res)
             return res;
+        RuntimeStats::count(RuntimeStats::SpecialSlowcases);
 #ifdef DEBUG_SLOWCASES
         SLOWCASE_COUNTER.count("special", call, ctx);
 #endif
@@ -1522,6 +1588,88 @@ static R_INLINE int R_integer_uminus(int x, Rboolean* pnaflag) {
         BINOP_FALLBACK(#op);                                                   \
     } while (false)
 
+// Quickening, see BC_quickened_list.h. The generic instruction is at pc - 1,
+// since none of the quickenable instructions have immediates. Code objects
+// with polymorphic arithmetic stop quickening once they reverted more than
+// RIR_DEQUICKEN_LIMIT quickened instructions, to avoid flip-flopping.
+#define QUICKEN(op)                                                            \
+    do {                                                                       \
+        if (c->dequickenCount < pir::Parameter::RIR_DEQUICKEN_LIMIT) {         \
+            if (IS_SIMPLE_SCALAR(lhs, INTSXP) &&                               \
+                IS_SIMPLE_SCALAR(rhs, INTSXP))                                 \
+                *(pc - 1) = Opcode::op##_int_int_;                             \
+            else if (IS_SIMPLE_SCALAR(lhs, REALSXP) &&                         \
+                     IS_SIMPLE_SCALAR(rhs, REALSXP))                           \
+                *(pc - 1) = Opcode::op##_real_real_;                           \
+        }                                                                      \
+    } while (false)
+
+#define DEQUICKEN(op)                                                          \
+    do {                                                                       \
+        *(pc - 1) = Opcode::op##_;                                             \
+        c->registerDequicken();                                                \
+    } while (false)
+
+static RIR_INLINE int R_integer_arith(Binop op, int x, int y,
+                                      Rboolean* pnaflag) {
+    switch (op) {
+    case Binop::PLUSOP:
+        return R_integer_plus(x, y, pnaflag);
+    case Binop::MINUSOP:
+        return R_integer_minus(x, y, pnaflag);
+    case Binop::TIMESOP:
+        return R_integer_times(x, y, pnaflag);
+    }
+    assert(false);
+    return NA_INTEGER;
+}
+
+// Quickened binops only check for the operand types they were specialized for,
+// on mismatch they dequicken and run the generic instruction.
+#define DO_QUICKENED_INT_BINOP(op, op2, generic)                               \
+    do {                                                                       \
+        if (IS_SIMPLE_SCALAR(lhs, INTSXP) && IS_SIMPLE_SCALAR(rhs, INTSXP)) {  \
+            Rboolean naflag = FALSE;                                           \
+            int int_res =                                                      \
+                R_integer_arith(op2, *INTEGER(lhs), *INTEGER(rhs), &naflag);   \
+            CHECK_INTEGER_OVERFLOW(R_NilValue, naflag);                        \
+            STORE_BINOP(INTSXP, int_res, 0);                                   \
+            R_Visible = (Rboolean) true;                                       \
+        } else {                                                               \
+            DEQUICKEN(generic);                                                \
+            DO_BINOP(op, op2);                                                 \
+        }                                                                      \
+    } while (false)
+
+#define DO_QUICKENED_REAL_BINOP(op, op2, generic)                              \
+    do {                                                                       \
+        if (IS_SIMPLE_SCALAR(lhs, REALSXP) &&                                  \
+            IS_SIMPLE_SCALAR(rhs, REALSXP)) {                                  \
+            double real_res = (*REAL(lhs) == NA_REAL || *REAL(rhs) == NA_REAL) \
+                                  ? NA_REAL                                    \
+                                  : *REAL(lhs) op * REAL(rhs);                 \
+            STORE_BINOP(REALSXP, 0, real_res);                                 \
+            R_Visible = (Rboolean) true;                                       \
+        } else {                                                               \
+            DEQUICKEN(generic);                                                \
+            DO_BINOP(op, op2);                                                 \
+        }                                                                      \
+    } while (false)
+
+#define DO_QUICKENED_RELOP(op, generic, type, access, na)                      \
+    do {                                                                       \
+        if (IS_SIMPLE_SCALAR(lhs, type) && IS_SIMPLE_SCALAR(rhs, type)) {      \
+            if (*access(lhs) == na || *access(rhs) == na)                      \
+                res = R_LogicalNAValue;                                        \
+            else                                                               \
+                res = *access(lhs) op * access(rhs) ? R_TrueValue              \
+                                                    : R_FalseValue;            \
+        } else {                                                               \
+            DEQUICKEN(generic);                                                \
+            DO_RELOP(op);                                                      \
+        }                                                                      \
+    } while (false)
+
 SEXP seq_int(int n1, int n2) {
     int n = n1 <= n2 ? n2 - n1 + 1 : n1 - n2 + 1;
     SEXP ans = Rf_allocVector(INTSXP, n);
@@ -1598,6 +1746,7 @@ void deoptFramesWithContext(InterpreterInstance* ctx,
     SEXP deoptEnv = ostack_at(ctx, stackHeight);
     auto code = f.code;
     code->registerInvocation();
+    code->rearmFeedback();
 
     bool outermostFrame = pos == deoptData->numFrames - 1;
     bool innermostFrame = pos == 0;
@@ -1755,8 +1904,10 @@ size_t expandDotDotDotCallArgs(InterpreterInstance* ctx, size_t n,
             if (TYPEOF(ellipsis) == DOTSXP) {
                 while (ellipsis != R_NilValue) {
                     auto arg = CAR(ellipsis);
-                    if (TYPEOF(arg) == LANGSXP || TYPEOF(arg) == SYMSXP)
+                    if (TYPEOF(arg) == LANGSXP || TYPEOF(arg) == SYMSXP) {
+                        RuntimeStats::count(RuntimeStats::PromiseAllocations);
                         arg = Rf_mkPROMISE(arg, env);
+                    }
                     args.push_back(arg);
                     names.push_back(TAG(ellipsis));
                     if (TAG(ellipsis) != R_NilValue)
@@ -1928,11 +2079,167 @@ SEXP colonCastRhs(SEXP newLhs, SEXP rhs) {
     return result;
 }
 
+SEXP growVector(SEXP vec, R_xlen_t newLength) {
+    SLOWASSERT(!MAYBE_SHARED(vec) && !ALTREP(vec));
+    SLOWASSERT(ATTRIB(vec) == R_NilValue);
+    R_xlen_t length = XLENGTH(vec);
+    assert(newLength >= length);
+
+    if (IS_GROWABLE(vec) && XTRUELENGTH(vec) >= newLength) {
+        SETLENGTH(vec, newLength);
+        return vec;
+    }
+
+    // Double the capacity, such that appending in a loop stays amortized
+    // linear. GNU-R only over-allocates by 5% in EnlargeVector.
+    R_xlen_t capacity = newLength;
+    if (length <= R_XLEN_T_MAX / 2 && 2 * length > capacity)
+        capacity = 2 * length;
+    if (capacity < 4)
+        capacity = 4;
+
+    auto type = TYPEOF(vec);
+    PROTECT(vec);
+    SEXP res = Rf_allocVector(type, capacity);
+    UNPROTECT(1);
+    switch (type) {
+    case LGLSXP:
+    case INTSXP:
+        memcpy(INTEGER(res), INTEGER(vec), length * sizeof(int));
+        break;
+    case REALSXP:
+        memcpy(REAL(res), REAL(vec), length * sizeof(double));
+        break;
+    case STRSXP:
+        for (R_xlen_t i = 0; i < length; ++i)
+            SET_STRING_ELT(res, i, STRING_ELT(vec, i));
+        break;
+    case VECSXP:
+        for (R_xlen_t i = 0; i < length; ++i)
+            SET_VECTOR_ELT(res, i, VECTOR_ELT(vec, i));
+        break;
+    default:
+        assert(false);
+    }
+    if (capacity > newLength) {
+        SET_GROWABLE_BIT(res);
+        SET_TRUELENGTH(res, capacity);
+        SETLENGTH(res, newLength);
+    }
+    return res;
+}
+
+SEXP appendScalar(SEXP vec, SEXP idx, SEXP val) {
+    SLOWASSERT(!MAYBE_SHARED(vec));
+    if (isObject(vec) || ALTREP(vec) || ATTRIB(vec) != R_NilValue)
+        return nullptr;
+    auto type = TYPEOF(vec);
+    if ((type != LGLSXP && type != INTSXP && type != REALSXP) ||
+        !IS_SIMPLE_SCALAR(val, type))
+        return nullptr;
+
+    R_xlen_t length = XLENGTH(vec);
+    if (IS_SIMPLE_SCALAR(idx, INTSXP)) {
+        if (*INTEGER(idx) == NA_INTEGER || *INTEGER(idx) != length + 1)
+            return nullptr;
+    } else if (IS_SIMPLE_SCALAR(idx, REALSXP)) {
+        if (*REAL(idx) != (double)(length + 1))
+            return nullptr;
+    } else {
+        return nullptr;
+    }
+
+    vec = growVector(vec, length + 1);
+    if (type == REALSXP)
+        REAL(vec)[length] = *REAL(val);
+    else
+        INTEGER(vec)[length] = *INTEGER(val);
+    return vec;
+}
+
+static bool appendInPlace(SEXP vec, SEXP val) {
+    if (vec == val || MAYBE_SHARED(vec) || isObject(vec) || isObject(val) ||
+        ALTREP(vec) || ALTREP(val) || ATTRIB(vec) != R_NilValue ||
+        ATTRIB(val) != R_NilValue)
+        return false;
+
+    // The order of types in which c coerces its arguments
+    auto rank = [](SEXPTYPE t) {
+        switch (t) {
+        case LGLSXP:
+            return 1;
+        case INTSXP:
+            return 2;
+        case REALSXP:
+            return 3;
+        default:
+            return 0;
+        }
+    };
+    auto vecType = TYPEOF(vec);
+    auto valType = TYPEOF(val);
+    if (vecType == STRSXP)
+        return valType == STRSXP;
+    return rank(vecType) && rank(valType) && rank(valType) <= rank(vecType);
+}
+
+SEXP appendVector(SEXP call, SEXP vec, SEXP val, SEXP env) {
+    if (appendInPlace(vec, val)) {
+        R_xlen_t length = XLENGTH(vec);
+        R_xlen_t n = XLENGTH(val);
+        if (n == 0)
+            return vec;
+        PROTECT(val);
+        vec = growVector(vec, length + n);
+        switch (TYPEOF(vec)) {
+        case LGLSXP:
+        case INTSXP:
+            memcpy(INTEGER(vec) + length, INTEGER(val), n * sizeof(int));
+            break;
+        case REALSXP:
+            if (TYPEOF(val) == REALSXP) {
+                memcpy(REAL(vec) + length, REAL(val), n * sizeof(double));
+            } else {
+                for (R_xlen_t i = 0; i < n; ++i) {
+                    auto v = INTEGER(val)[i];
+                    REAL(vec)[length + i] = v == NA_INTEGER ? NA_REAL : v;
+                }
+            }
+            break;
+        case STRSXP:
+            for (R_xlen_t i = 0; i < n; ++i)
+                SET_STRING_ELT(vec, length + i, STRING_ELT(val, i));
+            break;
+        default:
+            assert(false);
+        }
+        UNPROTECT(1);
+        R_Visible = TRUE;
+        return vec;
+    }
+
+    SEXP prim = SYMVALUE(symbol::c);
+    SEXP args = PROTECT(CONS_NR(vec, CONS_NR(val, R_NilValue)));
+    SEXP res = getBuiltin(prim)(call, prim, args, env);
+    R_Visible = TRUE;
+    UNPROTECT(1);
+    return res;
+}
+
 SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
                  const CallContext* callCtxt, Opcode* initialPC,
                  BindingCache* cache) {
     assert(env != symbol::delayedEnv || (callCtxt != nullptr));
 
+    if (c->flags.contains(Code::Lazy)) {
+        assert(!initialPC && !cache);
+        c = c->materialized();
+    }
+
+    // Loop bodies pass the binding cache of their frame, deopt does not
+    SamplingProfiler::Frame profilerFrame(c, callCtxt, initialPC && !cache,
+                                          cache);
+
     checkUserInterrupt();
     assert((!initialPC || !c->nativeCode) && "Cannot jump into native code");
     if (c->nativeCode) {
@@ -1988,7 +2295,8 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
     // marks how this load behaved.
     auto recordForceBehavior = [&](SEXP s) {
         // Bail if this load not recorded or we are in already optimized code
-        if (*pc != Opcode::record_type_)
+        if (*pc != Opcode::record_type_ ||
+            c->flags.contains(Code::StableFeedback))
             return;
 
         ObservedValues::StateBeforeLastForce state =
@@ -2001,8 +2309,10 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
             state = ObservedValues::StateBeforeLastForce::promise;
 
         ObservedValues* feedback = (ObservedValues*)(pc + 1);
-        if (feedback->stateBeforeLastForce < state)
+        if (feedback->stateBeforeLastForce < state) {
             feedback->stateBeforeLastForce = state;
+            c->feedbackChanged();
+        }
     };
 
     // main loop
@@ -2284,24 +2594,40 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
 
         INSTRUCTION(record_call_) {
             ObservedCallees* feedback = (ObservedCallees*)pc;
-            SEXP callee = ostack_top(ctx);
-            feedback->record(c, callee);
+            // The call counter is used to estimate call frequencies, it has to
+            // stay in sync with the invocation count.
+            if (c->flags.contains(Code::StableFeedback)) {
+                feedback->recordTaken();
+            } else {
+                SEXP callee = ostack_top(ctx);
+                feedbackRecorded(c, feedback->record(c, callee));
+            }
+            if (c->flags.contains(Code::ObservingFeedback))
+                FeedbackWindow::recordCall(c, pc, ostack_top(ctx));
             pc += sizeof(ObservedCallees);
             NEXT();
         }
 
         INSTRUCTION(record_test_) {
-            ObservedTest* feedback = (ObservedTest*)pc;
-            SEXP t = ostack_top(ctx);
-            feedback->record(t);
+            if (!c->flags.contains(Code::StableFeedback)) {
+                ObservedTest* feedback = (ObservedTest*)pc;
+                SEXP t = ostack_top(ctx);
+                feedbackRecorded(c, feedback->record(t));
+            }
+            if (c->flags.contains(Code::ObservingFeedback))
+                FeedbackWindow::recordTest(c, pc, ostack_top(ctx));
             pc += sizeof(ObservedTest);
             NEXT();
         }
 
         INSTRUCTION(record_type_) {
-            ObservedValues* feedback = (ObservedValues*)pc;
-            SEXP t = ostack_top(ctx);
-            feedback->record(t);
+            if (!c->flags.contains(Code::StableFeedback)) {
+                ObservedValues* feedback = (ObservedValues*)pc;
+                SEXP t = ostack_top(ctx);
+                feedbackRecorded(c, feedback->record(t, c));
+            }
+            if (c->flags.contains(Code::ObservingFeedback))
+                FeedbackWindow::recordType(c, pc, ostack_top(ctx));
             pc += sizeof(ObservedValues);
             NEXT();
         }
@@ -2461,6 +2787,7 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
         INSTRUCTION(mk_eager_promise_) {
             Immediate id = readImmediate();
             advanceImmediate();
+            RuntimeStats::count(RuntimeStats::PromiseAllocations);
             SEXP prom = Rf_mkPROMISE(c->getPromise(id)->container(), env);
             SEXP val = ostack_pop(ctx);
             assert(TYPEOF(val) != PROMSXP);
@@ -2473,6 +2800,7 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
         INSTRUCTION(mk_promise_) {
             Immediate id = readImmediate();
             advanceImmediate();
+            RuntimeStats::count(RuntimeStats::PromiseAllocations);
             SEXP prom = Rf_mkPROMISE(c->getPromise(id)->container(), env);
             ostack_push(ctx, prom);
             NEXT();
@@ -2571,10 +2899,25 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
         INSTRUCTION(add_) {
             SEXP lhs = ostack_at(ctx, 1);
             SEXP rhs = ostack_at(ctx, 0);
+            QUICKEN(add);
             DO_BINOP(+, Binop::PLUSOP);
             NEXT();
         }
 
+        INSTRUCTION(add_int_int_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_INT_BINOP(+, Binop::PLUSOP, add);
+            NEXT();
+        }
+
+        INSTRUCTION(add_real_real_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_REAL_BINOP(+, Binop::PLUSOP, add);
+            NEXT();
+        }
+
         INSTRUCTION(uplus_) {
             SEXP val = ostack_at(ctx, 0);
             DO_UNOP(+, Unop::PLUSOP);
@@ -2599,10 +2942,25 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
         INSTRUCTION(sub_) {
             SEXP lhs = ostack_at(ctx, 1);
             SEXP rhs = ostack_at(ctx, 0);
+            QUICKEN(sub);
             DO_BINOP(-, Binop::MINUSOP);
             NEXT();
         }
 
+        INSTRUCTION(sub_int_int_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_INT_BINOP(-, Binop::MINUSOP, sub);
+            NEXT();
+        }
+
+        INSTRUCTION(sub_real_real_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_REAL_BINOP(-, Binop::MINUSOP, sub);
+            NEXT();
+        }
+
         INSTRUCTION(uminus_) {
             SEXP val = ostack_at(ctx, 0);
             DO_UNOP(-, Unop::MINUSOP);
@@ -2612,10 +2970,25 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
         INSTRUCTION(mul_) {
             SEXP lhs = ostack_at(ctx, 1);
             SEXP rhs = ostack_at(ctx, 0);
+            QUICKEN(mul);
             DO_BINOP(*, Binop::TIMESOP);
             NEXT();
         }
 
+        INSTRUCTION(mul_int_int_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_INT_BINOP(*, Binop::TIMESOP, mul);
+            NEXT();
+        }
+
+        INSTRUCTION(mul_real_real_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_REAL_BINOP(*, Binop::TIMESOP, mul);
+            NEXT();
+        }
+
         INSTRUCTION(div_) {
             SEXP lhs = ostack_at(ctx, 1);
             SEXP rhs = ostack_at(ctx, 0);
@@ -2748,48 +3121,143 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
         INSTRUCTION(lt_) {
             SEXP lhs = ostack_at(ctx, 1);
             SEXP rhs = ostack_at(ctx, 0);
+            QUICKEN(lt);
             DO_RELOP(<);
             ostack_popn(ctx, 2);
             ostack_push(ctx, res);
             NEXT();
         }
 
+        INSTRUCTION(lt_int_int_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_RELOP(<, lt, INTSXP, INTEGER, NA_INTEGER);
+            ostack_popn(ctx, 2);
+            ostack_push(ctx, res);
+            NEXT();
+        }
+
+        INSTRUCTION(lt_real_real_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_RELOP(<, lt, REALSXP, REAL, NA_REAL);
+            ostack_popn(ctx, 2);
+            ostack_push(ctx, res);
+            NEXT();
+        }
+
         INSTRUCTION(gt_) {
             SEXP lhs = ostack_at(ctx, 1);
             SEXP rhs = ostack_at(ctx, 0);
+            QUICKEN(gt);
             DO_RELOP(>);
             ostack_popn(ctx, 2);
             ostack_push(ctx, res);
             NEXT();
         }
 
+        INSTRUCTION(gt_int_int_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_RELOP(>, gt, INTSXP, INTEGER, NA_INTEGER);
+            ostack_popn(ctx, 2);
+            ostack_push(ctx, res);
+            NEXT();
+        }
+
+        INSTRUCTION(gt_real_real_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_RELOP(>, gt, REALSXP, REAL, NA_REAL);
+            ostack_popn(ctx, 2);
+            ostack_push(ctx, res);
+            NEXT();
+        }
+
         INSTRUCTION(le_) {
             SEXP lhs = ostack_at(ctx, 1);
             SEXP rhs = ostack_at(ctx, 0);
+            QUICKEN(le);
             DO_RELOP(<=);
             ostack_popn(ctx, 2);
             ostack_push(ctx, res);
             NEXT();
         }
 
+        INSTRUCTION(le_int_int_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_RELOP(<=, le, INTSXP, INTEGER, NA_INTEGER);
+            ostack_popn(ctx, 2);
+            ostack_push(ctx, res);
+            NEXT();
+        }
+
+        INSTRUCTION(le_real_real_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_RELOP(<=, le, REALSXP, REAL, NA_REAL);
+            ostack_popn(ctx, 2);
+            ostack_push(ctx, res);
+            NEXT();
+        }
+
         INSTRUCTION(ge_) {
             SEXP lhs = ostack_at(ctx, 1);
             SEXP rhs = ostack_at(ctx, 0);
+            QUICKEN(ge);
             DO_RELOP(>=);
             ostack_popn(ctx, 2);
             ostack_push(ctx, res);
             NEXT();
         }
 
+        INSTRUCTION(ge_int_int_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_RELOP(>=, ge, INTSXP, INTEGER, NA_INTEGER);
+            ostack_popn(ctx, 2);
+            ostack_push(ctx, res);
+            NEXT();
+        }
+
+        INSTRUCTION(ge_real_real_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_RELOP(>=, ge, REALSXP, REAL, NA_REAL);
+            ostack_popn(ctx, 2);
+            ostack_push(ctx, res);
+            NEXT();
+        }
+
         INSTRUCTION(eq_) {
             SEXP lhs = ostack_at(ctx, 1);
             SEXP rhs = ostack_at(ctx, 0);
+            QUICKEN(eq);
             DO_RELOP(==);
             ostack_popn(ctx, 2);
             ostack_push(ctx, res);
             NEXT();
         }
 
+        INSTRUCTION(eq_int_int_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_RELOP(==, eq, INTSXP, INTEGER, NA_INTEGER);
+            ostack_popn(ctx, 2);
+            ostack_push(ctx, res);
+            NEXT();
+        }
+
+        INSTRUCTION(eq_real_real_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_RELOP(==, eq, REALSXP, REAL, NA_REAL);
+            ostack_popn(ctx, 2);
+            ostack_push(ctx, res);
+            NEXT();
+        }
+
         INSTRUCTION(identical_noforce_) {
             SEXP rhs = ostack_pop(ctx);
             SEXP lhs = ostack_pop(ctx);
@@ -2818,12 +3286,31 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
             assert(R_PPStackTop >= 0);
             SEXP lhs = ostack_at(ctx, 1);
             SEXP rhs = ostack_at(ctx, 0);
+            QUICKEN(ne);
             DO_RELOP(!=);
             ostack_popn(ctx, 2);
             ostack_push(ctx, res);
             NEXT();
         }
 
+        INSTRUCTION(ne_int_int_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_RELOP(!=, ne, INTSXP, INTEGER, NA_INTEGER);
+            ostack_popn(ctx, 2);
+            ostack_push(ctx, res);
+            NEXT();
+        }
+
+        INSTRUCTION(ne_real_real_) {
+            SEXP lhs = ostack_at(ctx, 1);
+            SEXP rhs = ostack_at(ctx, 0);
+            DO_QUICKENED_RELOP(!=, ne, REALSXP, REAL, NA_REAL);
+            ostack_popn(ctx, 2);
+            ostack_push(ctx, res);
+            NEXT();
+        }
+
         INSTRUCTION(not_) {
             SEXP val = ostack_at(ctx, 0);
 
@@ -3049,6 +3536,7 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
             advanceJump();
             if (ostack_pop(ctx) == R_TrueValue) {
                 checkUserInterrupt();
+                profilerFrame.at(pc);
                 pc += offset;
             }
             PC_BOUNDSCHECK(pc, c);
@@ -3060,6 +3548,7 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
             advanceJump();
             if (ostack_pop(ctx) == R_FalseValue) {
                 checkUserInterrupt();
+                profilerFrame.at(pc);
                 pc += offset;
             }
             PC_BOUNDSCHECK(pc, c);
@@ -3070,6 +3559,7 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
             JumpOffset offset = readJumpOffset();
             advanceJump();
             checkUserInterrupt();
+            profilerFrame.at(pc);
             pc += offset;
             PC_BOUNDSCHECK(pc, c);
             NEXT();
@@ -3287,6 +3777,13 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
                 ostack_set(ctx, 1, vec);
             }
 
+            // Appending a scalar, grow the vector in place
+            if ((res = appendScalar(vec, idx, val))) {
+                ostack_popn(ctx, 3);
+                ostack_push(ctx, res);
+                NEXT();
+            }
+
             SEXP args = CONS_NR(vec, CONS_NR(idx, CONS_NR(val, R_NilValue)));
             SET_TAG(CDDR(args), symbol::value);
             PROTECT(args);
@@ -3480,6 +3977,13 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
                 ostack_set(ctx, 1, vec);
             }
 
+            // Appending a scalar, grow the vector in place
+            if ((res = appendScalar(vec, idx, val))) {
+                ostack_popn(ctx, 3);
+                ostack_push(ctx, res);
+                NEXT();
+            }
+
             SEXP args = CONS_NR(vec, CONS_NR(idx, CONS_NR(val, R_NilValue)));
             SET_TAG(CDDR(args), symbol::value);
             PROTECT(args);
@@ -3624,6 +4128,16 @@ SEXP evalRirCode(Code* c, InterpreterInstance* ctx, SEXP env,
             NEXT();
         }
 
+        INSTRUCTION(append_) {
+            SEXP val = ostack_at(ctx, 0);
+            SEXP vec = ostack_at(ctx, 1);
+            SEXP call = getSrcForCall(c, pc - 1, ctx);
+            res = appendVector(call, vec, val, env);
+            ostack_popn(ctx, 2);
+            ostack_push(ctx, res);
+            NEXT();
+        }
+
         INSTRUCTION(guard_fun_) {
             SEXP sym = readConst(ctx, readImmediate());
             advanceImmediate();
@@ -114,6 +114,9 @@ void deoptFramesWithContext(InterpreterInstance* ctx,
                             size_t pos, size_t stackHeight,
                             RCNTXT* currentContext);
 void recordDeoptReason(SEXP val, const DeoptReason& reason);
+// True if the reason recorded for the current deopt pins it to one
+// speculation, which the next version will not repeat. Resets the flag.
+bool deoptHasSite();
 void jit(SEXP cls, SEXP name, InterpreterInstance* ctx);
 
 SEXP seq_int(int n1, int n2);
@@ -123,6 +126,16 @@ bool isColonFastcase(SEXP, SEXP);
 SEXP colonCastLhs(SEXP lhs);
 SEXP colonCastRhs(SEXP newLhs, SEXP rhs);
 
+// Vectors built by appending keep spare capacity (TRUELENGTH) which is doubled
+// whenever it runs out. growVector sets the length of an unshared vector
+// without attributes to newLength, reallocating only if there is no room left.
+SEXP growVector(SEXP vec, R_xlen_t newLength);
+// `x[length(x) + 1] <- val` for an unshared vector, or nullptr if val is not
+// a simple scalar of the same type as vec.
+SEXP appendScalar(SEXP vec, SEXP idx, SEXP val);
+// `x <- c(x, val)`, see the append_ instruction.
+SEXP appendVector(SEXP call, SEXP vec, SEXP val, SEXP env);
+
 inline void forceAll(SEXP list, InterpreterInstance* ctx) {
     while (list != R_NilValue) {
         if (TYPEOF(CAR(list)) == PROMSXP)
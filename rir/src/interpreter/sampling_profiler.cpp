@@ -0,0 +1,468 @@
+#include "sampling_profiler.h"
+#include "interp.h"
+#include "runtime/DispatchTable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <signal.h>
+#include <sstream>
+#include <string>
+#include <sys/time.h>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace rir {
+
+bool SamplingProfiler::active = false;
+
+namespace {
+
+struct ShadowFrame {
+    Code* code;
+    // Call ast and callee, nullptr for promises and top level code
+    SEXP ast;
+    SEXP callee;
+    // Last backedge taken by the interpreter
+    const Opcode* pc;
+    uintptr_t sp;
+    bool deopt;
+};
+
+static constexpr int MAX_FRAMES = 4096;
+static constexpr size_t MAX_SAMPLE_DEPTH = 128;
+static constexpr size_t BUFFERED_SAMPLES = 64;
+
+// Innermost frame first
+struct RawSample {
+    size_t depth;
+    // Index of the innermost frame on the shadow stack
+    int top;
+    ShadowFrame frames[MAX_SAMPLE_DEPTH];
+};
+
+struct Location {
+    std::string name;
+    SamplingProfiler::Tier tier;
+    std::string version;
+    // 0 if unknown
+    int file;
+    int line;
+
+    bool operator<(const Location& other) const {
+        return std::tie(name, tier, version, file, line) <
+               std::tie(other.name, other.tier, other.version, other.file,
+                        other.line);
+    }
+};
+
+} // namespace
+
+static ShadowFrame shadowStack[MAX_FRAMES];
+static volatile int depth = 0;
+
+static RawSample* buffer = nullptr;
+static volatile size_t buffered = 0;
+static volatile size_t dropped = 0;
+static long intervalUsec = 0;
+static struct sigaction previousHandler;
+
+static std::vector<Location> locations;
+static std::map<Location, size_t> locationIds;
+static std::vector<std::string> files;
+static std::unordered_map<std::string, int> fileIds;
+// Innermost location first
+static std::map<std::vector<size_t>, size_t> stacks;
+// Only valid during one drain, while the frames keep body and ast alive
+static std::map<std::pair<SEXP, SEXP>, std::pair<int, int>> lineCache;
+
+static const char* tierName(SamplingProfiler::Tier t) {
+    switch (t) {
+    case SamplingProfiler::Tier::Baseline:
+        return "baseline";
+    case SamplingProfiler::Tier::Optimized:
+        return "optimized";
+    case SamplingProfiler::Tier::Native:
+        return "native";
+    case SamplingProfiler::Tier::Deopt:
+        return "deopt";
+    }
+    assert(false);
+    return "";
+}
+
+static void handler(int) {
+    if (buffered == BUFFERED_SAMPLES) {
+        dropped = dropped + 1;
+        return;
+    }
+    auto& sample = buffer[buffered];
+    size_t n = 0;
+    for (int i = depth - 1; i >= 0 && n < MAX_SAMPLE_DEPTH; --i)
+        sample.frames[n++] = shadowStack[i];
+    sample.depth = n;
+    sample.top = depth - 1;
+    buffered = buffered + 1;
+}
+
+static bool contains(SEXP e, SEXP ast) {
+    if (e == ast)
+        return true;
+    if (TYPEOF(e) != LANGSXP && TYPEOF(e) != LISTSXP)
+        return false;
+    for (; e != R_NilValue; e = CDR(e))
+        if (contains(CAR(e), ast))
+            return true;
+    return false;
+}
+
+// The parser only attaches srcrefs to the statements of braced blocks. Returns
+// the one of the innermost statement around ast.
+static SEXP findSrcref(SEXP e, SEXP ast) {
+    if (TYPEOF(e) != LANGSXP)
+        return nullptr;
+    auto refs = Rf_getAttrib(e, R_SrcrefSymbol);
+    if (CAR(e) == R_BraceSymbol && TYPEOF(refs) == VECSXP) {
+        int i = 1;
+        for (auto s = CDR(e); s != R_NilValue; s = CDR(s), ++i) {
+            if (!contains(CAR(s), ast))
+                continue;
+            if (auto inner = findSrcref(CAR(s), ast))
+                return inner;
+            return i < Rf_length(refs) ? VECTOR_ELT(refs, i) : nullptr;
+        }
+        return nullptr;
+    }
+    for (auto s = CDR(e); s != R_NilValue; s = CDR(s))
+        if (auto inner = findSrcref(CAR(s), ast))
+            return inner;
+    return nullptr;
+}
+
+static int fileId(SEXP srcref) {
+    static SEXP filenameSym = Rf_install("filename");
+    auto srcfile = Rf_getAttrib(srcref, R_SrcfileSymbol);
+    if (TYPEOF(srcfile) != ENVSXP)
+        return 0;
+    auto name = Rf_findVarInFrame(srcfile, filenameSym);
+    if (TYPEOF(name) != STRSXP || Rf_length(name) == 0)
+        return 0;
+    std::string n = CHAR(STRING_ELT(name, 0));
+    auto f = fileIds.find(n);
+    if (f != fileIds.end())
+        return f->second;
+    files.push_back(n);
+    return fileIds[n] = files.size();
+}
+
+// File and line of ast in the body of a closure
+static std::pair<int, int> lineOf(SEXP body, SEXP ast) {
+    auto key = std::make_pair(body, ast);
+    auto cached = lineCache.find(key);
+    if (cached != lineCache.end())
+        return cached->second;
+    std::pair<int, int> res(0, 0);
+    auto srcref = findSrcref(body, ast);
+    if (srcref && TYPEOF(srcref) == INTSXP && Rf_length(srcref) > 0) {
+        if (auto file = fileId(srcref))
+            res = std::make_pair(file, INTEGER(srcref)[0]);
+    }
+    lineCache.emplace(key, res);
+    return res;
+}
+
+static size_t locationId(const Location& l) {
+    auto id = locationIds.find(l);
+    if (id != locationIds.end())
+        return id->second;
+    locations.push_back(l);
+    return locationIds[l] = locations.size() - 1;
+}
+
+// The first alive frames of the shadow stack are still running, everything
+// they refer to is alive. Frames of a sample which were left since then might
+// refer to collected objects.
+static bool isAlive(const RawSample& sample, size_t i, int alive) {
+    int index = sample.top - (int)i;
+    if (index < 0 || index >= alive)
+        return false;
+    auto& f = sample.frames[i];
+    auto& s = shadowStack[index];
+    return s.sp == f.sp && s.code == f.code && s.callee == f.callee &&
+           s.ast == f.ast;
+}
+
+static void record(const RawSample& sample, int alive) {
+    auto ctx = globalContext();
+    std::vector<size_t> stack;
+    for (size_t i = 0; i < sample.depth; ++i) {
+        auto& f = sample.frames[i];
+        if (!isAlive(sample, i, alive))
+            continue;
+        // Promises and top level code are attributed to the closure frames
+        // around them, like Rprof does.
+        if (!f.callee || TYPEOF(f.callee) != CLOSXP)
+            continue;
+        auto table = DispatchTable::check(BODY(f.callee));
+        if (!table)
+            continue;
+
+        Location l;
+        auto fun = CAR(f.ast);
+        l.name = TYPEOF(fun) == SYMSXP ? CHAR(PRINTNAME(fun)) : "<Anonymous>";
+
+        Function* version = nullptr;
+        for (size_t v = 0; v < table->size(); ++v)
+            if (table->get(v)->body() == f.code)
+                version = table->get(v);
+        if (version) {
+            std::stringstream ctxt;
+            ctxt << version->context();
+            l.version = ctxt.str();
+        }
+        if (f.code->nativeCode)
+            l.tier = SamplingProfiler::Tier::Native;
+        else if (f.deopt)
+            l.tier = SamplingProfiler::Tier::Deopt;
+        else if (version == table->baseline())
+            l.tier = SamplingProfiler::Tier::Baseline;
+        else
+            l.tier = SamplingProfiler::Tier::Optimized;
+
+        // The line is the one of the call to the next inner closure, or the
+        // last backedge of an interpreted innermost frame.
+        SEXP current = nullptr;
+        for (size_t j = i; j > 0 && !current; --j)
+            if (isAlive(sample, j - 1, alive))
+                current = sample.frames[j - 1].ast;
+        if (!current && f.pc && !f.code->nativeCode) {
+            if (auto idx = f.code->getSrcIdxAt(f.pc, true))
+                current = src_pool_at(ctx, idx);
+        }
+        l.file = l.line = 0;
+        if (current) {
+            auto body = src_pool_at(ctx, table->baseline()->body()->src);
+            std::tie(l.file, l.line) = lineOf(body, current);
+        }
+        stack.push_back(locationId(l));
+    }
+    stacks[stack]++;
+}
+
+// Frames below here on the C stack were left by a longjump
+static int aliveBelow(uintptr_t here) {
+    int d = depth;
+    while (d > 0 && shadowStack[d - 1].sp <= here)
+        d--;
+    return d;
+}
+
+static void drain(int alive) {
+    sigset_t prof, old;
+    sigemptyset(&prof);
+    sigaddset(&prof, SIGPROF);
+    sigprocmask(SIG_BLOCK, &prof, &old);
+    for (size_t i = 0; i < buffered; ++i)
+        record(buffer[i], alive);
+    buffered = 0;
+    lineCache.clear();
+    sigprocmask(SIG_SETMASK, &old, nullptr);
+}
+
+static void drainHere() {
+    int here;
+    drain(aliveBelow((uintptr_t)&here));
+}
+
+int SamplingProfiler::enter(Code* code, const CallContext* call, bool deopt,
+                            bool loop, void* sp) {
+    auto here = (uintptr_t)sp;
+    int d = aliveBelow(here);
+    if (buffered)
+        drain(d);
+    depth = d;
+
+    if (loop)
+        return d > 0 && shadowStack[d - 1].code == code ? d - 1 : -1;
+    if (d == MAX_FRAMES)
+        return -1;
+
+    auto& f = shadowStack[d];
+    f.code = code;
+    f.ast = call ? call->ast : nullptr;
+    f.callee = call ? call->callee : nullptr;
+    f.pc = nullptr;
+    f.sp = here;
+    f.deopt = deopt;
+    // The handler must not see the frame before it is complete
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    depth = d + 1;
+    return d;
+}
+
+void SamplingProfiler::leave(int index) {
+    // The frame is still alive, the samples it is part of are attributed now
+    if (buffered)
+        drain(index + 1);
+    depth = index;
+}
+
+void SamplingProfiler::at(int index, const Opcode* pc) {
+    if (buffered)
+        drain(index + 1);
+    // Nothing above a frame which executes a backedge is alive
+    depth = index + 1;
+    shadowStack[index].pc = pc;
+}
+
+void SamplingProfiler::start(double interval) {
+    if (active)
+        stop();
+    if (!buffer)
+        buffer = new RawSample[BUFFERED_SAMPLES];
+
+    locations.clear();
+    locationIds.clear();
+    files.clear();
+    fileIds.clear();
+    stacks.clear();
+    lineCache.clear();
+    buffered = 0;
+    dropped = 0;
+    intervalUsec = interval * 1e6;
+    if (intervalUsec <= 0)
+        intervalUsec = 1;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(struct sigaction));
+    sa.sa_handler = handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, &previousHandler) < 0)
+        Rf_error("cannot install the profiling signal handler");
+
+    struct itimerval timer;
+    timer.it_interval.tv_sec = intervalUsec / 1000000;
+    timer.it_interval.tv_usec = intervalUsec % 1000000;
+    timer.it_value = timer.it_interval;
+    active = true;
+    setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+void SamplingProfiler::stop() {
+    if (!active)
+        return;
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(struct itimerval));
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    sigaction(SIGPROF, &previousHandler, nullptr);
+    active = false;
+    drainHere();
+}
+
+void SamplingProfiler::writeRprof(std::ostream& out) {
+    if (active)
+        drainHere();
+    out << "line profiling: sample.interval=" << intervalUsec << "\n";
+    for (size_t i = 0; i < files.size(); ++i)
+        out << "#File " << i + 1 << ": " << files[i] << "\n";
+    for (auto& s : stacks) {
+        std::stringstream line;
+        for (auto id : s.first) {
+            auto& l = locations[id];
+            if (l.line)
+                line << l.file << "#" << l.line << " ";
+            line << "\"" << l.name << "\" ";
+        }
+        for (size_t i = 0; i < s.second; ++i)
+            out << line.str() << "\n";
+    }
+}
+
+void SamplingProfiler::writeCollapsed(std::ostream& out) {
+    if (active)
+        drainHere();
+    for (auto& s : stacks) {
+        if (s.first.empty())
+            continue;
+        for (auto id = s.first.rbegin(); id != s.first.rend(); ++id) {
+            auto& l = locations[*id];
+            std::stringstream label;
+            label << l.name << " [" << tierName(l.tier);
+            if (!l.version.empty())
+                label << " " << l.version;
+            label << "]";
+            if (l.line)
+                label << " " << files[l.file - 1] << ":" << l.line;
+            auto str = label.str();
+            // The separator of the frames
+            std::replace(str.begin(), str.end(), ';', ' ');
+            if (id != s.first.rbegin())
+                out << ";";
+            out << str;
+        }
+        out << " " << s.second << "\n";
+    }
+}
+
+SEXP SamplingProfiler::summary() {
+    if (active)
+        drainHere();
+    std::vector<size_t> self(locations.size()), total(locations.size());
+    for (auto& s : stacks) {
+        if (s.first.empty())
+            continue;
+        self[s.first.front()] += s.second;
+        std::vector<bool> seen(locations.size());
+        for (auto id : s.first) {
+            if (!seen[id])
+                total[id] += s.second;
+            seen[id] = true;
+        }
+    }
+
+    auto n = locations.size();
+    auto function = PROTECT(Rf_allocVector(STRSXP, n));
+    auto tier = PROTECT(Rf_allocVector(STRSXP, n));
+    auto version = PROTECT(Rf_allocVector(STRSXP, n));
+    auto file = PROTECT(Rf_allocVector(STRSXP, n));
+    auto line = PROTECT(Rf_allocVector(INTSXP, n));
+    auto selfSamples = PROTECT(Rf_allocVector(INTSXP, n));
+    auto totalSamples = PROTECT(Rf_allocVector(INTSXP, n));
+    for (size_t i = 0; i < n; ++i) {
+        auto& l = locations[i];
+        SET_STRING_ELT(function, i, Rf_mkChar(l.name.c_str()));
+        SET_STRING_ELT(tier, i, Rf_mkChar(tierName(l.tier)));
+        SET_STRING_ELT(version, i, Rf_mkChar(l.version.c_str()));
+        SET_STRING_ELT(file, i,
+                       l.file ? Rf_mkChar(files[l.file - 1].c_str())
+                              : NA_STRING);
+        INTEGER(line)[i] = l.line ? l.line : NA_INTEGER;
+        INTEGER(selfSamples)[i] = self[i];
+        INTEGER(totalSamples)[i] = total[i];
+    }
+
+    const char* names[] = {"function", "tier",  "version", "file",
+                           "line",     "self", "total",   ""};
+    auto res = PROTECT(Rf_mkNamed(VECSXP, names));
+    SET_VECTOR_ELT(res, 0, function);
+    SET_VECTOR_ELT(res, 1, tier);
+    SET_VECTOR_ELT(res, 2, version);
+    SET_VECTOR_ELT(res, 3, file);
+    SET_VECTOR_ELT(res, 4, line);
+    SET_VECTOR_ELT(res, 5, selfSamples);
+    SET_VECTOR_ELT(res, 6, totalSamples);
+
+    auto rowNames = PROTECT(Rf_allocVector(INTSXP, 2));
+    INTEGER(rowNames)[0] = NA_INTEGER;
+    INTEGER(rowNames)[1] = -(int)n;
+    Rf_setAttrib(res, R_RowNamesSymbol, rowNames);
+    Rf_setAttrib(res, R_ClassSymbol, Rf_mkString("data.frame"));
+    Rf_setAttrib(res, Rf_install("dropped"), Rf_ScalarInteger(dropped));
+    UNPROTECT(9);
+    return res;
+}
+
+} // namespace rir
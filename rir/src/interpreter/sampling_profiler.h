@@ -0,0 +1,80 @@
+#ifndef RIR_SAMPLING_PROFILER_H
+#define RIR_SAMPLING_PROFILER_H
+
+#include "R/r.h"
+#include "ir/BC_inc.h"
+
+#include <cstdint>
+#include <ostream>
+
+namespace rir {
+
+struct Code;
+struct CallContext;
+
+/*
+ * R-level sampling profiler, which understands rir frames.
+ *
+ * Every evaluation of rir code registers a frame on a shadow stack, while
+ * the profiler is running. A SIGPROF timer copies the shadow stack into a
+ * preallocated buffer (no allocation in the handler). The copies are
+ * attributed to closure, tier, dispatch version and source line at the next
+ * safepoint (frame entry, frame exit or loop backedge) and when the profiler
+ * is stopped. Frames which were left by a longjump before that are skipped.
+ *
+ * Frames which are left by a longjump are not popped, they are dropped by the
+ * next frame entry or backedge on a lower frame (the C stack grows
+ * downwards). Inlined callees are attributed to the optimized caller. Native
+ * code has no pc to source mapping, the line of a native frame is only known
+ * if it is currently calling another closure.
+ */
+class SamplingProfiler {
+  public:
+    enum class Tier : uint8_t { Baseline, Optimized, Native, Deopt };
+
+    static bool active;
+
+    // Registers an evaluation of code with the profiler for its lifetime
+    class Frame {
+      public:
+        // Loop bodies are evaluated by a recursive call, they continue the
+        // frame of their code instead of pushing a new one.
+        Frame(Code* code, const CallContext* call, bool deopt, bool loop)
+            : loop(loop),
+              index(active ? enter(code, call, deopt, loop, this) : -1) {}
+        ~Frame() {
+            if (index >= 0 && !loop)
+                leave(index);
+        }
+
+        // Called on backedges, to know the line of a running loop
+        void at(const Opcode* pc) {
+            if (index >= 0)
+                SamplingProfiler::at(index, pc);
+        }
+
+      private:
+        const bool loop;
+        const int index;
+    };
+
+    static void start(double interval);
+    static void stop();
+    // Output compatible with Rprof(line.profiling = TRUE)
+    static void writeRprof(std::ostream& out);
+    // Collapsed stacks, as consumed by flamegraph.pl
+    static void writeCollapsed(std::ostream& out);
+    // data.frame with self and total samples per closure, tier, version and
+    // line
+    static SEXP summary();
+
+  private:
+    static int enter(Code* code, const CallContext* call, bool deopt,
+                     bool loop, void* sp);
+    static void leave(int index);
+    static void at(int index, const Opcode* pc);
+};
+
+} // namespace rir
+
+#endif
@@ -216,7 +216,9 @@ void BC::serialize(SEXP refTable, R_outpstream_t out, const Opcode* code,
                    size_t codeSize, const Code* container) {
     while (codeSize > 0) {
         const BC bc = BC::decode((Opcode*)code, container);
-        OutChar(out, (int)*code);
+        // Quickening is a runtime property of this code object, serialize the
+        // generic instruction
+        OutChar(out, (int)BC::dequicken(*code));
         unsigned size = BC::fixedSize(*code);
         ImmediateArguments i = bc.immediate;
         switch (*code) {
@@ -345,6 +347,12 @@ void BC::print(std::ostream& out) const {
                 if (i != (unsigned)prof.numTypes - 1)
                     out << ", ";
             }
+            if (prof.notNA)
+                out << " notNA";
+            if (prof.monomorphicConstant)
+                out << " const";
+            if (prof.deopts)
+                out << " deopts: " << (int)prof.deopts;
             if (prof.stateBeforeLastForce !=
                 ObservedValues::StateBeforeLastForce::unknown) {
                 out << " | "
@@ -442,6 +450,8 @@ void BC::print(std::ostream& out) const {
         for (int i = 0; i < prof.numTargets; ++i)
             out << callFeedbackExtra().targets[i] << "("
                 << type2char(TYPEOF(callFeedbackExtra().targets[i])) << ") ";
+        if (prof.deopts)
+            out << "deopts: " << prof.deopts << " ";
         out << "]";
         break;
     }
@@ -462,6 +472,8 @@ void BC::print(std::ostream& out) const {
             out << "?";
             break;
         }
+        if (immediate.testFeedback.deopts)
+            out << " deopts: " << immediate.testFeedback.deopts;
         out << " ]";
         break;
     }
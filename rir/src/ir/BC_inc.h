@@ -275,6 +275,23 @@ class BC {
 
     bool isExit() const { return bc == Opcode::ret_ || bc == Opcode::return_; }
 
+    // Quickened instructions (see BC_quickened_list.h) are an implementation
+    // detail of the interpreter. Everybody else should treat them as their
+    // generic counterpart.
+    bool isQuickened() const { return dequicken(bc) != bc; }
+
+    static Opcode dequicken(Opcode bc) {
+        switch (bc) {
+#define V(NESTED, op, lhs, rhs)                                                \
+    case Opcode::op##_##lhs##_##rhs##_:                                        \
+        return Opcode::op##_;
+            BC_QUICKENED(V, _)
+#undef V
+        default:
+            return bc;
+        }
+    }
+
     // This code performs the same as `BC::decode(pc).size()`, but for
     // performance reasons, it avoids actually creating the BC object.
     // This is important, as it is very performance critical.
@@ -1,12 +1,16 @@
 #ifndef BC_NOARG_LIST_H
 #define BC_NOARG_LIST_H
 
+#include "BC_quickened_list.h"
 #include "simple_instruction_list.h"
 
 #define V_SIMPLE_INSTRUCTION_IN_BC_NOARGS(V, name, Name) V(_, name, name)
+#define V_QUICKENED_IN_BC_NOARGS(V, op, lhs, rhs)                              \
+    V(_, op##_##lhs##_##rhs, op##_##lhs##_##rhs)
 
 #define BC_NOARGS(V, NESTED)                                                   \
     SIMPLE_INSTRUCTIONS(V_SIMPLE_INSTRUCTION_IN_BC_NOARGS, V)                  \
+    BC_QUICKENED(V_QUICKENED_IN_BC_NOARGS, V)                                  \
     V(NESTED, nop, nop)                                                        \
     V(NESTED, ret, ret)                                                        \
     V(NESTED, pop, pop)                                                        \
@@ -62,7 +66,8 @@
     V(NESTED, return_, return )                                                \
     V(NESTED, colonInputEffects, colon_input_effects)                          \
     V(NESTED, colonCastLhs, colon_cast_lhs)                                    \
-    V(NESTED, colonCastRhs, colon_cast_rhs)
+    V(NESTED, colonCastRhs, colon_cast_rhs)                                    \
+    V(NESTED, append, append)
 
 #undef V_SIMPLE_INSTRUCTION
 
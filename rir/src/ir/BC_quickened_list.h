@@ -0,0 +1,37 @@
+#ifndef BC_QUICKENED_LIST_H
+#define BC_QUICKENED_LIST_H
+
+// Quickened instructions are specialized variants of the generic arithmetic
+// and relational instructions. They are never emitted by the compiler. Instead
+// the interpreter rewrites a generic instruction in place, once it observed
+// two simple scalar operands of the same type. A quickened instruction only
+// checks for the operand types it was specialized for and otherwise rewrites
+// itself back to the generic instruction (dequickening).
+//
+// Everything but the interpreter should see the generic instruction, see
+// BC::dequicken.
+//
+// - V(NESTED, <generic instruction>, <lhs type>, <rhs type>)
+//   declares the instruction <generic instruction>_<lhs type>_<rhs type>_
+
+#define BC_QUICKENED(V, NESTED)                                                \
+    V(NESTED, add, int, int)                                                   \
+    V(NESTED, add, real, real)                                                 \
+    V(NESTED, sub, int, int)                                                   \
+    V(NESTED, sub, real, real)                                                 \
+    V(NESTED, mul, int, int)                                                   \
+    V(NESTED, mul, real, real)                                                 \
+    V(NESTED, lt, int, int)                                                    \
+    V(NESTED, lt, real, real)                                                  \
+    V(NESTED, gt, int, int)                                                    \
+    V(NESTED, gt, real, real)                                                  \
+    V(NESTED, le, int, int)                                                    \
+    V(NESTED, le, real, real)                                                  \
+    V(NESTED, ge, int, int)                                                    \
+    V(NESTED, ge, real, real)                                                  \
+    V(NESTED, eq, int, int)                                                    \
+    V(NESTED, eq, real, real)                                                  \
+    V(NESTED, ne, int, int)                                                    \
+    V(NESTED, ne, real, real)
+
+#endif
@@ -102,6 +102,10 @@ static Sources hasSources(Opcode bc) {
     case Opcode::subassign1_2_:
     case Opcode::subassign2_2_:
     case Opcode::subassign1_3_:
+    case Opcode::append_:
+#define V(NESTED, op, lhs, rhs) case Opcode::op##_##lhs##_##rhs##_:
+BC_QUICKENED(V, _)
+#undef V
         return Sources::Required;
 
     case Opcode::inc_:
@@ -254,6 +258,13 @@ void CodeVerifier::verifyFunctionLayout(SEXP sexp, InterpreterInstance* ctx) {
             Rf_error("RIR Verifier: Invalid code magic number");
         if (c->src == 0)
             Rf_error("RIR Verifier: Code must have AST");
+        if (c->flags.contains(Code::Lazy)) {
+            if (c->codeSize != 0)
+                Rf_error("RIR Verifier: Lazy code stub must not have code");
+            if (c->extraPoolSize)
+                objs.push_back(c->getPromise(0));
+            continue;
+        }
         unsigned oldo = c->stackLength;
         calculateAndVerifyStack(c);
         if (oldo != c->stackLength)
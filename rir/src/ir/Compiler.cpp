@@ -194,6 +194,7 @@ struct LoadArgsResult {
 };
 
 Code* compilePromise(CompilerContext& ctx, SEXP exp);
+Code* compileArgPromise(CompilerContext& ctx, SEXP exp);
 // If we are in a void context, then compile expression will not leave a value
 // on the stack. For example in `{a; b}` the expression `a` is in a void
 // context, but `b` is not. In `while(...) {...}` all loop body expressions are
@@ -410,6 +411,54 @@ static bool maybeChanges(SEXP sym, SEXP ast) {
     return false;
 }
 
+// Compile the rhs of `x <- c(x, val)` to an append_, which grows the vector
+// bound to x in-place instead of copying it on every iteration. If c is not
+// the base primitive, the rhs is compiled as a regular call.
+static bool compileAppend(CompilerContext& ctx, SEXP target, SEXP rhs) {
+    if (TYPEOF(rhs) != LANGSXP || CAR(rhs) != symbol::c)
+        return false;
+    RList args(CDR(rhs));
+    if (args.length() != 2)
+        return false;
+    auto vec = args.begin();
+    auto val = vec + 1;
+    if (*vec != target || vec.hasTag() || val.hasTag() ||
+        *val == R_DotsSymbol || *val == R_MissingArg ||
+        maybeChanges(target, *val))
+        return false;
+
+    CodeStream& cs = ctx.cs();
+    BC::Label callBranch = cs.mkLabel();
+    BC::Label contBranch = cs.mkLabel();
+    if (!Compiler::unsoundOpts) {
+        cs << BC::ldfun(symbol::c) << BC::push(CDR(symbol::c))
+           << BC::identicalNoforce() << BC::recordTest()
+           << BC::brfalse(callBranch);
+    }
+
+    if (ctx.code.top()->isCached(target))
+        cs << BC::ldvarForUpdateCached(target,
+                                       ctx.code.top()->cacheSlotFor(target));
+    else
+        cs << BC::ldvarForUpdate(target);
+    if (Compiler::profile)
+        cs << BC::recordType();
+
+    compileExpr(ctx, *val);
+    cs << BC::append();
+    cs.addSrc(rhs);
+    if (Compiler::profile)
+        cs << BC::recordType();
+
+    if (!Compiler::unsoundOpts) {
+        cs << BC::br(contBranch);
+        cs << callBranch;
+        compileExpr(ctx, rhs);
+        cs << contBranch;
+    }
+    return true;
+}
+
 // Inline some specials
 // TODO: once we have sufficiently powerful analysis this should (maybe?) go
 //       away and move to an optimization phase.
@@ -602,7 +651,8 @@ bool compileSpecialCall(CompilerContext& ctx, SEXP ast, SEXP fun, SEXP args_,
         // 2) Specialcalse normal assignment (ie. "i <- expr")
         if (TYPEOF(lhs) == SYMSXP) {
             emitGuardForNamePrimitive(cs, fun);
-            compileExpr(ctx, rhs);
+            if (superAssign || !compileAppend(ctx, lhs, rhs))
+                compileExpr(ctx, rhs);
             if (!voidContext) {
                 // No ensureNamed needed, stvar already ensures named
                 cs << BC::dup() << BC::invisible();
@@ -1452,7 +1502,7 @@ static LoadArgsResult compileLoadArgs(CompilerContext& ctx, SEXP ast, SEXP fun,
 
         // (1) Arguments are wrapped as Promises:
         //     create a new Code object for the promise
-        Code* prom = compilePromise(ctx, *arg);
+        Code* prom = compileArgPromise(ctx, *arg);
         size_t idx = cs.addPromise(prom);
 
         // (2) remember if the argument had a name associated
@@ -1472,6 +1522,8 @@ static LoadArgsResult compileLoadArgs(CompilerContext& ctx, SEXP ast, SEXP fun,
                     res.assumptions.setSimpleReal(i);
                 if (IS_SIMPLE_SCALAR(known, INTSXP))
                     res.assumptions.setSimpleInt(i);
+                if (IS_SIMPLE_SCALAR(known, LGLSXP))
+                    res.assumptions.setSimpleLgl(i);
             }
             cs << BC::push(known);
             cs << BC::mkEagerPromise(idx);
@@ -1602,6 +1654,30 @@ Code* compilePromise(CompilerContext& ctx, SEXP exp) {
     return ctx.pop();
 }
 
+// break and next in a promise need to know the enclosing loop of the caller,
+// thus such promises cannot be compiled in isolation.
+static bool mayJumpToLoop(SEXP exp) {
+    if (exp == symbol::Break || exp == symbol::Next)
+        return true;
+    if (TYPEOF(exp) != LANGSXP && TYPEOF(exp) != LISTSXP)
+        return false;
+    for (auto e = exp; e != R_NilValue; e = CDR(e))
+        if (mayJumpToLoop(CAR(e)))
+            return true;
+    return false;
+}
+
+// Most argument promises and default arguments are never forced. Unless
+// trivial, they are only compiled on first use.
+Code* compileArgPromise(CompilerContext& ctx, SEXP exp) {
+    if (TYPEOF(exp) == LANGSXP && !mayJumpToLoop(exp)) {
+        auto stub = Code::NewLazy(exp);
+        ctx.preserve(stub->container());
+        return stub;
+    }
+    return compilePromise(ctx, exp);
+}
+
 }  // anonymous namespace
 
 SEXP Compiler::finalize() {
@@ -1616,7 +1692,7 @@ SEXP Compiler::finalize() {
         if (*arg == R_MissingArg) {
             function.addArgWithoutDefault();
         } else {
-            Code* compiled = compilePromise(ctx, *arg);
+            Code* compiled = compileArgPromise(ctx, *arg);
             function.addDefaultArg(compiled);
         }
         signature.pushFormal(*arg, arg.tag());
@@ -1636,6 +1712,13 @@ SEXP Compiler::finalize() {
     return function.function()->container();
 }
 
+Code* Compiler::compileDeferred(SEXP ast) {
+    Preserve preserve;
+    FunctionWriter function;
+    CompilerContext ctx(function, preserve);
+    return compilePromise(ctx, ast);
+}
+
 bool Compiler::unsoundOpts =
     !(getenv("UNSOUND_OPTS") &&
       std::string(getenv("UNSOUND_OPTS")).compare("off") == 0);
@@ -91,6 +91,10 @@ class Compiler {
         return vtable->container();
     }
 
+    // Compiles the code of a promise or default argument, which was deferred
+    // until its first use (see Code::Lazy).
+    static Code* compileDeferred(SEXP ast);
+
     static void compileClosure(SEXP inClosure) {
 
         assert(TYPEOF(inClosure) == CLOSXP);
@@ -2,6 +2,8 @@
 #error "DEF_INSTR must be defined before including insns.h"
 #endif
 
+#include "BC_quickened_list.h"
+
 // DEF_INSTR(name, imm, pop, push, pure)
 
 /**
@@ -448,4 +450,25 @@ DEF_INSTR(record_test_, 1, 1, 1, 0)
 DEF_INSTR(int3_, 0, 0, 0, 0)
 DEF_INSTR(printInvocation_, 0, 0, 0, 0)
 
+/**
+ * add_int_int_, lt_real_real_, ...:: quickened versions of the arithmetic and
+ * relational instructions above, see BC_quickened_list.h. Installed by the
+ * interpreter only.
+ */
+#define DEF_QUICKENED_INSTR(NESTED, op, lhs, rhs)                              \
+    DEF_INSTR(op##_##lhs##_##rhs##_, 0, 2, 1, 0)
+BC_QUICKENED(DEF_QUICKENED_INSTR, _)
+#undef DEF_QUICKENED_INSTR
+
+/**
+ * append_ :: c(a, b)
+ *
+ * this instruction creates the rhs part of a <- c(a, b) and still needs to be
+ * assigned.
+ *
+ * Warning: like the subassigns, on named == 1 it appends to a in-place, using
+ * the spare capacity of growable vectors.
+ */
+DEF_INSTR(append_, 0, 2, 1, 1)
+
 #undef DEF_INSTR
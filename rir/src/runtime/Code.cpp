@@ -3,6 +3,7 @@
 #include "R/Printing.h"
 #include "R/Serialize.h"
 #include "ir/BC.h"
+#include "ir/Compiler.h"
 #include "utils/Pool.h"
 
 #include <iomanip>
@@ -18,7 +19,9 @@ Code::Code(FunctionSEXP fun, SEXP src, unsigned srcIdx, unsigned cs,
           (intptr_t)&locals_ - (intptr_t)this,
           // GC area has only 1 pointer
           NumLocals),
-      nativeCode(nullptr), funInvocationCount(0), deoptCount(0), src(srcIdx),
+      nativeCode(nullptr), funInvocationCount(0), deoptCount(0),
+      dequickenCount(0), unchangedFeedbackCount(0), feedbackEpoch(0),
+      callsSinceWindow(0), windowCallsLeft(0), windowBackoff(0), src(srcIdx),
       trivialExpr(nullptr), stackLength(0), localsCount(localsCnt),
       bindingCacheSize(bindingsCnt), codeSize(cs), srcLength(sourceLength),
       extraPoolSize(0) {
@@ -44,6 +47,25 @@ Code* Code::New(Immediate ast, size_t codeSize, size_t sources, size_t locals,
 
 Code* Code::New(Immediate ast) { return New(ast, 0, 0, 0, 0); }
 
+Code* Code::NewLazy(SEXP ast) {
+    auto c = New(ast, 0, 0, 0, 0);
+    c->flags.set(Lazy);
+    return c;
+}
+
+Code* Code::materialized() {
+    if (!flags.contains(Lazy))
+        return this;
+    // The compiled code is kept in the extra pool of the stub
+    if (extraPoolSize)
+        return getPromise(0);
+    auto res = Compiler::compileDeferred(src_pool_at(globalContext(), src));
+    PROTECT(res->container());
+    addExtraPoolEntry(res->container());
+    UNPROTECT(1);
+    return res;
+}
+
 Code::~Code() {
     // TODO: Not sure if this is actually called
     // Otherwise the pointer will leak a few bytes
@@ -106,6 +128,8 @@ Code* Code::deserialize(SEXP refTable, R_inpstream_t inp) {
     code->codeSize = InInteger(inp);
     code->srcLength = InInteger(inp);
     code->extraPoolSize = InInteger(inp);
+    if (InInteger(inp))
+        code->flags.set(Lazy);
     SEXP extraPool = ReadItem(refTable, inp);
     PROTECT(extraPool);
 
@@ -143,6 +167,7 @@ void Code::serialize(SEXP refTable, R_outpstream_t out) const {
     OutInteger(out, codeSize);
     OutInteger(out, srcLength);
     OutInteger(out, extraPoolSize);
+    OutInteger(out, flags.contains(Lazy));
     WriteItem(getEntry(0), refTable, out);
 
     // Bytecode
@@ -157,6 +182,14 @@ void Code::serialize(SEXP refTable, R_outpstream_t out) const {
 }
 
 void Code::disassemble(std::ostream& out, const std::string& prefix) const {
+    if (flags.contains(Lazy)) {
+        if (extraPoolSize)
+            getPromise(0)->disassemble(out, prefix);
+        else
+            out << "(not compiled yet)\n";
+        return;
+    }
+
     if (auto map = pirTypeFeedback()) {
         map->forEachSlot([&](size_t i,
                              const PirTypeFeedback::MDEntry& mdEntry) {
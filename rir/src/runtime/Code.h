@@ -47,8 +47,9 @@ typedef SEXP (*NativeCode)(Code*, void*, SEXP, SEXP);
 struct Code : public RirRuntimeObject<Code, CODE_MAGIC> {
     friend class FunctionWriter;
     friend class CodeVerifier;
-    // extra pool, pir type feedback, arg reordering info
-    static constexpr size_t NumLocals = 3;
+    // extra pool, pir type feedback, arg reordering info, feedback window,
+    // deferred native code
+    static constexpr size_t NumLocals = 5;
 
     Code(FunctionSEXP fun, SEXP src, unsigned srcIdx, unsigned codeSize,
          unsigned sourceSize, size_t localsCnt, size_t bindingsCacheSize);
@@ -57,11 +58,13 @@ struct Code : public RirRuntimeObject<Code, CODE_MAGIC> {
   private:
     Code() : Code(NULL, 0, 0, 0, 0, 0, 0) {}
     /*
-     * This array contains the GC reachable pointers. Currently there are three
+     * This array contains the GC reachable pointers. Currently there are five
      * of them.
      * 0 : the extra pool for attaching additional GC'd object to the code
      * 1 : pir type feedback
      * 2 : call argument reordering metadata
+     * 3 : feedback window (not serialized)
+     * 4 : module of native code which is not compiled yet (not serialized)
      */
     SEXP locals_[NumLocals];
 
@@ -71,6 +74,11 @@ struct Code : public RirRuntimeObject<Code, CODE_MAGIC> {
     static Code* New(Immediate ast, size_t codeSize, size_t sources,
                      size_t locals, size_t bindingCache);
     static Code* New(Immediate ast);
+    static Code* NewLazy(SEXP ast);
+
+    // Returns the compiled code for a Lazy stub (compiling it if needed) and
+    // the code itself otherwise.
+    Code* materialized();
 
     NativeCode nativeCode;
 
@@ -99,17 +107,59 @@ struct Code : public RirRuntimeObject<Code, CODE_MAGIC> {
     unsigned funInvocationCount;
     unsigned deoptCount;
 
+    // number of quickened instructions which had to be reverted to their
+    // generic version. not serialized, quickening is redone at runtime.
+    unsigned dequickenCount;
+    void registerDequicken() {
+        if (dequickenCount < UINT_MAX)
+            dequickenCount++;
+    }
+
     enum Flag {
         NeedsFullEnv,
         NoReflection,
         Reoptimise,
+        StableFeedback,
+        // The record_ instructions also record into the feedback window, see
+        // FeedbackWindow.
+        ObservingFeedback,
+        // The body can neither observe nor unwind to its RCNTXT, calls to it
+        // do not need to create one.
+        NoContext,
+        // Stub for promise or default argument code, which only holds the
+        // AST. The bytecode is compiled on first use, see materialized().
+        Lazy,
 
         FIRST = NeedsFullEnv,
-        LAST = Reoptimise
+        LAST = Lazy
     };
 
     EnumSet<Flag> flags;
 
+    // number of executed record_ instructions since the feedback of this code
+    // object last changed. Once it is stable for long enough, the record_
+    // instructions stop recording (see StableFeedback flag) until the next
+    // deopt re-arms them. not serialized.
+    unsigned unchangedFeedbackCount;
+    // incremented whenever the feedback of this code object changes or we
+    // deopt through it. cached PIR translations are only reused while it
+    // stays the same. not serialized.
+    unsigned feedbackEpoch;
+    void feedbackChanged() {
+        unchangedFeedbackCount = 0;
+        feedbackEpoch++;
+    }
+    void rearmFeedback() {
+        flags.reset(StableFeedback);
+        feedbackChanged();
+    }
+
+    // Bookkeeping of FeedbackWindow, only used on function bodies. not
+    // serialized.
+    unsigned callsSinceWindow;
+    unsigned windowCallsLeft;
+    uint8_t windowBackoff;
+
     unsigned src; /// AST of the function (or promise) represented by the code
 
     SEXP trivialExpr; /// If this code object is a trivial expression
@@ -183,6 +233,22 @@ struct Code : public RirRuntimeObject<Code, CODE_MAGIC> {
     void arglistOrder(ArglistOrder* data) { setEntry(2, data->container()); }
     SEXP arglistOrderContainer() const { return getEntry(2); }
 
+    // The feedback recorded during a window, at the same offsets as the
+    // record_ instructions' immediates in the code stream.
+    uint8_t* feedbackWindow() const {
+        SEXP window = getEntry(3);
+        if (!window)
+            return nullptr;
+        return RAW(window);
+    }
+    void feedbackWindow(SEXP window) { setEntry(3, window); }
+
+    // External pointer to the LLVM module of lazily compiled native code, see
+    // JitLLVM::compileLazy. Its finalizer drops the module, if the code dies
+    // before it was ever run.
+    SEXP deferredNativeCode() const { return getEntry(4); }
+    void deferredNativeCode(SEXP module) { setEntry(4, module); }
+
     size_t size() const {
         return sizeof(Code) + pad4(codeSize) + srcLength * sizeof(SrclistEntry);
     }
@@ -55,11 +55,18 @@ std::ostream& operator<<(std::ostream& out, TypeAssumption a) {
     case TypeAssumption::Arg5Is##Type##_:                                      \
         out << Msg << "5";                                                     \
         break;                                                                 \
+    case TypeAssumption::Arg6Is##Type##_:                                      \
+        out << Msg << "6";                                                     \
+        break;                                                                 \
+    case TypeAssumption::Arg7Is##Type##_:                                      \
+        out << Msg << "7";                                                     \
+        break;                                                                 \
 
         TYPE_ASSUMPTIONS(Eager, "Eager");
         TYPE_ASSUMPTIONS(NotObj, "!Obj");
         TYPE_ASSUMPTIONS(SimpleInt, "SimpleInt");
         TYPE_ASSUMPTIONS(SimpleReal, "SimpleReal");
+        TYPE_ASSUMPTIONS(SimpleLgl, "SimpleLgl");
         TYPE_ASSUMPTIONS(NonRefl, "NonRefl");
     }
     return out;
@@ -71,11 +78,12 @@ std::ostream& operator<<(std::ostream& out, const Context& a) {
         if (i + 1 != a.flags.end())
             out << ",";
     }
-    if (!a.typeFlags.empty())
+    auto typeFlags = a.typeFlags();
+    if (!typeFlags.empty())
         out << ";";
-    for (auto i = a.typeFlags.begin(); i != a.typeFlags.end(); ++i) {
+    for (auto i = typeFlags.begin(); i != typeFlags.end(); ++i) {
         out << *i;
-        if (i + 1 != a.typeFlags.end())
+        if (i + 1 != typeFlags.end())
             out << ",";
     }
     if (a.missing > 0)
@@ -91,6 +99,8 @@ constexpr std::array<TypeAssumption, Context::NUM_TYPED_ARGS>
     Context::SimpleIntContext;
 constexpr std::array<TypeAssumption, Context::NUM_TYPED_ARGS>
     Context::SimpleRealContext;
+constexpr std::array<TypeAssumption, Context::NUM_TYPED_ARGS>
+    Context::SimpleLglContext;
 constexpr std::array<TypeAssumption, Context::NUM_TYPED_ARGS>
     Context::NonReflContext;
 
@@ -102,28 +112,28 @@ void Context::setSpecializationLevel(int level) {
     // All Specialization Disabled
     case 0:
         flags = flags & preserve;
-        typeFlags.reset();
+        clearTypeFlags();
         missing = 0;
         break;
 
     // Eager Args
     case 1:
         flags = flags & preserve;
-        typeFlags = typeFlags & allEagerArgsFlags();
+        typeFlags(typeFlags() & allEagerArgsFlags());
         missing = 0;
         break;
 
     // + not Reflective
     case 2:
         flags.reset(Assumption::NoExplicitlyMissingArgs);
-        typeFlags = typeFlags & allEagerArgsFlags();
+        typeFlags(typeFlags() & allEagerArgsFlags());
         missing = 0;
         break;
 
     // + not Object
     case 3:
         flags.reset(Assumption::NoExplicitlyMissingArgs);
-        typeFlags = typeFlags & (allEagerArgsFlags() | allNonObjArgsFlags());
+        typeFlags(typeFlags() & (allEagerArgsFlags() | allNonObjArgsFlags()));
         missing = 0;
         break;
 
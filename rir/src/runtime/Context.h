@@ -10,6 +10,9 @@
 
 namespace rir {
 
+// Context is passed around as a single 64 bit word (in call immediates and to
+// the native call builtins). Only 48 bits are available for type assumptions,
+// see Context::typeFlags_.
 enum class TypeAssumption {
     // Arg is already evaluated
     Arg0IsEager_,
@@ -51,8 +54,30 @@ enum class TypeAssumption {
     Arg4IsSimpleReal_,
     Arg5IsSimpleReal_,
 
+    // The same for the arguments 6 and 7
+    Arg6IsEager_,
+    Arg7IsEager_,
+    Arg6IsNonRefl_,
+    Arg7IsNonRefl_,
+    Arg6IsNotObj_,
+    Arg7IsNotObj_,
+    Arg6IsSimpleInt_,
+    Arg7IsSimpleInt_,
+    Arg6IsSimpleReal_,
+    Arg7IsSimpleReal_,
+
+    // Arg is simple logical scalar
+    Arg0IsSimpleLgl_,
+    Arg1IsSimpleLgl_,
+    Arg2IsSimpleLgl_,
+    Arg3IsSimpleLgl_,
+    Arg4IsSimpleLgl_,
+    Arg5IsSimpleLgl_,
+    Arg6IsSimpleLgl_,
+    Arg7IsSimpleLgl_,
+
     FIRST = Arg0IsEager_,
-    LAST = Arg5IsSimpleReal_,
+    LAST = Arg7IsSimpleLgl_,
 };
 
 enum class Assumption {
@@ -73,26 +98,28 @@ class ClosureVersion;
 #pragma pack(push)
 #pragma pack(1)
 struct Context {
-    typedef EnumSet<TypeAssumption, uint32_t> TypeFlags;
+    typedef EnumSet<TypeAssumption, uint64_t> TypeFlags;
     typedef EnumSet<Assumption, uint8_t> Flags;
 
     constexpr static size_t MAX_MISSING = 255;
     // # of args with type assumptions
-    constexpr static size_t NUM_TYPED_ARGS = 6;
+    constexpr static size_t NUM_TYPED_ARGS = 8;
+    constexpr static size_t TYPE_FLAGS_BITS = 48;
+    static_assert((size_t)TypeAssumption::LAST < TYPE_FLAGS_BITS,
+                  "Type assumptions do not fit into the context");
 
-    Context() = default;
+    constexpr Context() : typeFlags_(0) {}
     Context(const Context&) noexcept = default;
 
-    explicit constexpr Context(const Flags& flags) : flags(flags) {}
+    explicit constexpr Context(const Flags& flags)
+        : flags(flags), typeFlags_(0) {}
     constexpr Context(const Flags& flags, uint8_t missing)
-        : flags(flags), missing(missing) {}
+        : flags(flags), missing(missing), typeFlags_(0) {}
     constexpr Context(const Flags& flags, const TypeFlags& typeFlags,
                       uint8_t missing)
-        : flags(flags), typeFlags(typeFlags), missing(missing) {}
+        : flags(flags), missing(missing), typeFlags_(typeFlags.to_i()) {}
     explicit Context(void* pos) { memcpy((void*)this, pos, sizeof(*this)); }
     explicit Context(unsigned long val) {
-        // Silence unused field warning
-        (void)unused2;
         memcpy((void*)this, &val, sizeof(*this));
     }
 
@@ -113,26 +140,28 @@ struct Context {
         Type##Context = {                                                      \
             {TypeAssumption::Arg0Is##Type##_, TypeAssumption::Arg1Is##Type##_, \
              TypeAssumption::Arg2Is##Type##_, TypeAssumption::Arg3Is##Type##_, \
-             TypeAssumption::Arg4Is##Type##_,                                  \
-             TypeAssumption::Arg5Is##Type##_}};                                \
+             TypeAssumption::Arg4Is##Type##_, TypeAssumption::Arg5Is##Type##_, \
+             TypeAssumption::Arg6Is##Type##_,                                  \
+             TypeAssumption::Arg7Is##Type##_}};                                \
     RIR_INLINE bool is##Type(size_t i) const {                                 \
         if (i < NUM_TYPED_ARGS)                                                \
-            if (typeFlags.includes(Type##Context[i]))                          \
+            if (typeFlags().includes(Type##Context[i]))                        \
                 return true;                                                   \
         return false;                                                          \
     }                                                                          \
     RIR_INLINE void reset##Type(size_t i) {                                    \
         if (i < NUM_TYPED_ARGS)                                                \
-            typeFlags.reset(Type##Context[i]);                                 \
+            typeFlags_ &= ~TypeFlags(Type##Context[i]).to_i();                 \
     }                                                                          \
     RIR_INLINE void set##Type(size_t i) {                                      \
         if (i < NUM_TYPED_ARGS)                                                \
-            typeFlags.set(Type##Context[i]);                                   \
+            typeFlags_ |= TypeFlags(Type##Context[i]).to_i();                  \
     }
     TYPE_ASSUMPTIONS(Eager);
     TYPE_ASSUMPTIONS(NotObj);
     TYPE_ASSUMPTIONS(SimpleInt);
     TYPE_ASSUMPTIONS(SimpleReal);
+    TYPE_ASSUMPTIONS(SimpleLgl);
     TYPE_ASSUMPTIONS(NonRefl);
 #undef TYPE_ASSUMPTIONS
 
@@ -140,13 +169,13 @@ struct Context {
         Context a;
         for (size_t i = 0; i < NUM_TYPED_ARGS; ++i)
             a.setEager(i);
-        return a.typeFlags;
+        return a.typeFlags();
     }
     static TypeFlags allNonObjArgsFlags() {
         Context a;
         for (size_t i = 0; i < NUM_TYPED_ARGS; ++i)
             a.setNotObj(i);
-        return a.typeFlags;
+        return a.typeFlags();
     }
 
     RIR_INLINE uint8_t numMissing() const { return missing; }
@@ -157,18 +186,18 @@ struct Context {
     }
 
     RIR_INLINE bool empty() const {
-        return flags.empty() && typeFlags.empty() && missing == 0;
+        return flags.empty() && typeFlags_ == 0 && missing == 0;
     }
 
     RIR_INLINE size_t count() const {
-        return flags.count() + typeFlags.count();
+        return flags.count() + typeFlags().count();
     }
 
     constexpr Context operator|(const Flags& other) const {
-        return Context(other | flags, typeFlags, missing);
+        return Context(other | flags, typeFlags(), missing);
     }
     constexpr Context operator|(const TypeFlags& other) const {
-        return Context(flags, other | typeFlags, missing);
+        return Context(flags, other | typeFlags(), missing);
     }
     constexpr Context operator|(const Context& other) const {
 
@@ -187,7 +216,7 @@ struct Context {
         }
 
         auto newMissing = other.missing > missing ? other.missing : missing;
-        return Context(other.flags | flags, other.typeFlags | typeFlags,
+        return Context(other.flags | flags, other.typeFlags() | typeFlags(),
                        newMissing);
     }
     constexpr Context operator&(const Context& other) const {
@@ -195,9 +224,9 @@ struct Context {
             auto min = missing > other.missing ? other.missing : missing;
             return Context(other.flags & flags &
                                ~Flags(Assumption::NoExplicitlyMissingArgs),
-                           other.typeFlags & typeFlags, min);
+                           other.typeFlags() & typeFlags(), min);
         }
-        return Context(other.flags & flags, other.typeFlags & typeFlags,
+        return Context(other.flags & flags, other.typeFlags() & typeFlags(),
                        missing);
     }
 
@@ -215,22 +244,22 @@ struct Context {
         // (more assumptions = smaller context)
         if (flags.count() != other.flags.count())
             return flags.count() > other.flags.count();
-        if (typeFlags.count() != other.typeFlags.count())
-            return typeFlags.count() > other.typeFlags.count();
+        if (typeFlags().count() != other.typeFlags().count())
+            return typeFlags().count() > other.typeFlags().count();
         if (missing != other.missing)
             return missing > other.missing;
         if (flags.to_i() != other.flags.to_i())
             return flags.to_i() > other.flags.to_i();
-        return typeFlags.to_i() > other.typeFlags.to_i();
+        return typeFlags_ > other.typeFlags_;
     }
 
     RIR_INLINE bool operator!=(const Context& other) const {
-        return flags != other.flags || typeFlags != other.typeFlags ||
+        return flags != other.flags || typeFlags_ != other.typeFlags_ ||
                missing != other.missing;
     }
 
     RIR_INLINE bool operator==(const Context& other) const {
-        return flags == other.flags && typeFlags == other.typeFlags &&
+        return flags == other.flags && typeFlags_ == other.typeFlags_ &&
                missing == other.missing;
     }
 
@@ -246,7 +275,7 @@ struct Context {
             return false;
 
         return flags.includes(other.flags) &&
-               typeFlags.includes(other.typeFlags);
+               (typeFlags_ & other.typeFlags_) == other.typeFlags_;
     }
 
     bool isImproving(rir::Function*) const;
@@ -262,12 +291,12 @@ struct Context {
 
     void clearExcept(const Flags& filter) {
         flags = flags & filter;
-        typeFlags.reset();
+        typeFlags_ = 0;
         missing = 0;
     }
 
     void clearTypeFlags() {
-        typeFlags.reset();
+        typeFlags_ = 0;
     }
 
     void clearNargs() {
@@ -283,10 +312,12 @@ struct Context {
     void setSpecializationLevel(int level);
 
   private:
+    constexpr TypeFlags typeFlags() const { return TypeFlags(typeFlags_); }
+    void typeFlags(const TypeFlags& f) { typeFlags_ = f.to_i(); }
+
     Flags flags;
-    TypeFlags typeFlags;
     uint8_t missing = 0;
-    uint16_t unused2 = 0;
+    uint64_t typeFlags_ : TYPE_FLAGS_BITS;
 };
 #pragma pack(pop)
 
@@ -304,7 +335,7 @@ template <>
 struct hash<rir::Context> {
     std::size_t operator()(const rir::Context& v) const {
         return hash_combine(
-            hash_combine(hash_combine(0, v.flags.to_i()), v.typeFlags.to_i()),
+            hash_combine(hash_combine(0, v.flags.to_i()), v.typeFlags().to_i()),
             v.missing);
     }
 };
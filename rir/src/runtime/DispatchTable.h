@@ -4,6 +4,7 @@
 #include "Function.h"
 #include "R/Serialize.h"
 #include "RirRuntimeObject.h"
+#include "runtime_stats.h"
 
 namespace rir {
 
@@ -22,6 +23,10 @@ struct DispatchTable
 
     size_t size() const { return size_; }
 
+    // Bumped whenever a version is added or removed. Native call sites
+    // remember it to notice when they need to dispatch again.
+    size_t version() const { return version_; }
+
     Function* get(size_t i) const {
         assert(i < capacity());
         return Function::unpack(getEntry(i));
@@ -62,6 +67,7 @@ struct DispatchTable
     void baseline(Function* f) {
         assert(f->signature().optimization ==
                FunctionSignature::OptimizationLevel::Baseline);
+        version_++;
         if (size() == 0)
             size_++;
         else
@@ -85,6 +91,7 @@ struct DispatchTable
         }
         if (i == size())
             return;
+        version_++;
         get(i)->flags.set(Function::Dead);
         for (; i < size() - 1; ++i) {
             setEntry(i, getEntry(i + 1));
@@ -99,6 +106,7 @@ struct DispatchTable
         assert(size() > 0);
         assert(fun->signature().optimization !=
                FunctionSignature::OptimizationLevel::Baseline);
+        version_++;
         auto assumptions = fun->context();
         long i;
         for (i = size() - 1; i > 0; --i) {
@@ -130,6 +138,7 @@ struct DispatchTable
             Rf_error("dispatch table overflow");
 #endif
             // Evict one element and retry
+            RuntimeStats::count(RuntimeStats::DispatchTableEvictions);
             auto pos = 1 + (std::rand() % (size() - 1));
             size_--;
             while (pos < size()) {
@@ -161,13 +170,13 @@ struct DispatchTable
     }
 
     static DispatchTable* create(size_t capacity = 20) {
-        size_t sz =
-            sizeof(DispatchTable) + (capacity * sizeof(DispatchTableEntry));
+        size_t sz = sizeof(DispatchTable) +
+                    ((capacity + 1) * sizeof(DispatchTableEntry));
         SEXP s = Rf_allocVector(EXTERNALSXP, sz);
         return new (INTEGER(s)) DispatchTable(capacity);
     }
 
-    size_t capacity() const { return info.gc_area_length; }
+    size_t capacity() const { return info.gc_area_length - 1; }
 
     static DispatchTable* deserialize(SEXP refTable, R_inpstream_t inp) {
         DispatchTable* table = create();
@@ -217,16 +226,23 @@ struct DispatchTable
         return userDefinedContext_ | anotherContext;
     }
 
+    // Deopt-less continuations of this closure (see pir::Deoptless). They
+    // are not versions, dispatch never selects them.
+    SEXP continuations() const { return getEntry(capacity()); }
+    void continuations(SEXP c) { setEntry(capacity(), c); }
+
   private:
     DispatchTable() = delete;
     explicit DispatchTable(size_t cap)
         : RirRuntimeObject(
               // GC area starts at the end of the DispatchTable
               sizeof(DispatchTable),
-              // GC area is just the pointers in the entry array
-              cap) {}
+              // GC area is the pointers in the entry array, followed by the
+              // continuations
+              cap + 1) {}
 
     size_t size_ = 0;
+    size_t version_ = 0;
     Context userDefinedContext_;
 };
 #pragma pack(pop)
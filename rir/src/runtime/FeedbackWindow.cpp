@@ -0,0 +1,192 @@
+#include "FeedbackWindow.h"
+#include "Code.h"
+#include "DispatchTable.h"
+#include "TypeFeedback.h"
+#include "compiler/parameter.h"
+#include "ir/BC.h"
+#include "runtime_stats.h"
+#include "utils/Pool.h"
+
+#include <cstring>
+
+namespace rir {
+
+unsigned pir::Parameter::RIR_FEEDBACK_EPOCH =
+    getenv("RIR_FEEDBACK_EPOCH") ? atoi(getenv("RIR_FEEDBACK_EPOCH")) : 1000;
+unsigned pir::Parameter::RIR_FEEDBACK_WINDOW =
+    getenv("RIR_FEEDBACK_WINDOW") ? atoi(getenv("RIR_FEEDBACK_WINDOW")) : 4;
+
+// The epoch of a function which stays polymorphic doubles after every window,
+// up to this many times
+static constexpr uint8_t MaxBackoff = 10;
+
+static bool enabled() {
+    return pir::Parameter::RIR_FEEDBACK_EPOCH &&
+           pir::Parameter::RIR_FEEDBACK_WINDOW;
+}
+
+static unsigned long epoch(Code* body) {
+    return (unsigned long)pir::Parameter::RIR_FEEDBACK_EPOCH
+           << body->windowBackoff;
+}
+
+// pc points to the immediate of a record_ instruction
+template <typename Feedback>
+static Feedback* windowOf(Code* c, Opcode* pc) {
+    return (Feedback*)(c->feedbackWindow() + (pc - c->code()));
+}
+
+static bool polymorphic(Code* body) {
+    for (auto pos = body->code(); pos != body->endCode(); pos = BC::next(pos)) {
+        auto imm = pos + 1;
+        switch (*pos) {
+        case Opcode::record_call_:
+            if (((ObservedCallees*)imm)->numTargets > 1)
+                return true;
+            break;
+        case Opcode::record_test_:
+            if (((ObservedTest*)imm)->seen == ObservedTest::Both)
+                return true;
+            break;
+        case Opcode::record_type_:
+            if (((ObservedValues*)imm)->numTypes > 1)
+                return true;
+            break;
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
+static bool open(Code* body) {
+    if (!polymorphic(body))
+        return false;
+    SEXP window = Rf_allocVector(RAWSXP, body->codeSize);
+    // All zero feedback has not recorded anything yet
+    memset(RAW(window), 0, body->codeSize);
+    body->feedbackWindow(window);
+    body->flags.set(Code::ObservingFeedback);
+    // The window refers to the callees recorded by the live feedback, it has
+    // to keep recording.
+    body->flags.reset(Code::StableFeedback);
+    body->unchangedFeedbackCount = 0;
+    body->windowCallsLeft = pir::Parameter::RIR_FEEDBACK_WINDOW;
+    RuntimeStats::count(RuntimeStats::FeedbackWindows);
+    return true;
+}
+
+// Returns true if the feedback changed and the optimized versions were
+// dropped
+static bool close(DispatchTable* table) {
+    auto body = table->baseline()->body();
+    auto window = body->feedbackWindow();
+    body->flags.reset(Code::ObservingFeedback);
+
+    bool narrowed = false;
+    auto narrow = [&](auto live, auto observed) {
+        if (observed->narrowerThan(*live)) {
+            live->narrowTo(*observed);
+            narrowed = true;
+        }
+    };
+    for (auto pos = body->code(); pos != body->endCode(); pos = BC::next(pos)) {
+        auto imm = pos + 1;
+        auto observed = window + (imm - body->code());
+        switch (*pos) {
+        case Opcode::record_call_:
+            narrow((ObservedCallees*)imm, (ObservedCallees*)observed);
+            break;
+        case Opcode::record_test_:
+            narrow((ObservedTest*)imm, (ObservedTest*)observed);
+            break;
+        case Opcode::record_type_:
+            narrow((ObservedValues*)imm, (ObservedValues*)observed);
+            break;
+        default:
+            break;
+        }
+    }
+    body->feedbackWindow(nullptr);
+
+    if (!narrowed) {
+        if (body->windowBackoff < MaxBackoff)
+            body->windowBackoff++;
+        return false;
+    }
+
+    // Like a deopt, the versions compiled from the old feedback are dropped
+    // and the baseline recompiles after the usual warmup. They might still be
+    // running, the pool keeps them alive.
+    RuntimeStats::count(RuntimeStats::FeedbackPhaseChanges);
+    body->feedbackChanged();
+    body->windowBackoff = 0;
+    while (table->size() > 1) {
+        auto fun = table->get(1);
+        Pool::insert(fun->container());
+        table->remove(fun->body());
+    }
+    return true;
+}
+
+Function* FeedbackWindow::dispatch(DispatchTable* table, Function* fun) {
+    if (!enabled())
+        return fun;
+    auto body = table->baseline()->body();
+    if (body->flags.contains(Code::ObservingFeedback)) {
+        if (body->windowCallsLeft > 0) {
+            body->windowCallsLeft--;
+            return table->baseline();
+        }
+        return close(table) ? table->baseline() : fun;
+    }
+
+    if (++body->callsSinceWindow < epoch(body))
+        return fun;
+    body->callsSinceWindow = 0;
+    if (!open(body))
+        return fun;
+    body->windowCallsLeft--;
+    return table->baseline();
+}
+
+bool FeedbackWindow::bypass(DispatchTable* table) {
+    if (!enabled())
+        return false;
+    auto body = table->baseline()->body();
+    if (body->flags.contains(Code::ObservingFeedback) ||
+        body->callsSinceWindow + 1 >= epoch(body))
+        return true;
+    body->callsSinceWindow++;
+    return false;
+}
+
+void FeedbackWindow::recordCall(Code* c, Opcode* pc, SEXP callee) {
+    auto live = (ObservedCallees*)pc;
+    auto window = windowOf<ObservedCallees>(c, pc);
+    if (window->numTargets == ObservedCallees::MaxTargets)
+        return;
+    for (size_t i = 0; i < live->numTargets; ++i) {
+        if (live->getTarget(c, i) != callee)
+            continue;
+        for (size_t j = 0; j < window->numTargets; ++j)
+            if (window->targets[j] == live->targets[i])
+                return;
+        window->targets[window->numTargets++] = live->targets[i];
+        return;
+    }
+    // The live feedback is full and does not know this callee
+    window->numTargets = ObservedCallees::MaxTargets;
+}
+
+void FeedbackWindow::recordTest(Code* c, Opcode* pc, SEXP value) {
+    windowOf<ObservedTest>(c, pc)->record(value);
+}
+
+void FeedbackWindow::recordType(Code* c, Opcode* pc, SEXP value) {
+    // Without the code object no constants are tracked, they would be added
+    // to the extra pool in every window.
+    windowOf<ObservedValues>(c, pc)->record(value);
+}
+
+} // namespace rir
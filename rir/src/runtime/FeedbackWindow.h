@@ -0,0 +1,51 @@
+#ifndef RIR_FEEDBACK_WINDOW_H
+#define RIR_FEEDBACK_WINDOW_H
+
+#include "R/r.h"
+#include "ir/BC_inc.h"
+
+namespace rir {
+
+struct Code;
+struct DispatchTable;
+struct Function;
+
+/*
+ * Aging of type feedback.
+ *
+ * The record_ feedback only ever widens. A function which saw messy types
+ * during a setup phase stays polymorphic, and its optimized versions stay
+ * generic, even if it only sees one type afterwards. Once optimized, its
+ * baseline code does not record anything anymore.
+ *
+ * Therefore every RIR_FEEDBACK_EPOCH calls of a function with polymorphic
+ * feedback in its body, the next RIR_FEEDBACK_WINDOW calls run in the
+ * baseline code. Meanwhile the record_ instructions also record into a fresh
+ * window. If the window is narrower than the accumulated feedback for some
+ * slots, the phase of the program changed: the feedback of these slots is
+ * replaced by the window and the optimized versions are reoptimized. If not,
+ * the epoch doubles, so functions which stay polymorphic are rarely
+ * observed.
+ *
+ * Only the feedback of the function body is aged, not the one of its
+ * promises. Calls within a single invocation (e.g. self-recursive calls from
+ * native code) are not counted.
+ */
+class FeedbackWindow {
+  public:
+    // Counts a call which goes through doCall. Returns the version to run,
+    // which is the baseline while a window is open.
+    static Function* dispatch(DispatchTable* table, Function* fun);
+    // Counts a call from a native call site, which is bound to a version.
+    // Returns true if it has to go through doCall instead, because a window
+    // is open or due.
+    static bool bypass(DispatchTable* table);
+
+    static void recordCall(Code* c, Opcode* pc, SEXP callee);
+    static void recordTest(Code* c, Opcode* pc, SEXP value);
+    static void recordType(Code* c, Opcode* pc, SEXP value);
+};
+
+} // namespace rir
+
+#endif
@@ -1,14 +1,14 @@
 #include "TypeFeedback.h"
 #include "R/r.h"
 #include "runtime/Code.h"
+#include "utils/Pool.h"
 
 #include <cassert>
 
 namespace rir {
 
-void ObservedCallees::record(Code* caller, SEXP callee) {
-    if (taken < CounterOverflow)
-        taken++;
+bool ObservedCallees::record(Code* caller, SEXP callee) {
+    recordTaken();
     if (numTargets < MaxTargets) {
         int i = 0;
         for (; i < numTargets; ++i)
@@ -17,8 +17,35 @@ void ObservedCallees::record(Code* caller, SEXP callee) {
         if (i == numTargets) {
             auto idx = caller->addExtraPoolEntry(callee);
             targets[numTargets++] = idx;
+            return true;
         }
     }
+    return false;
+}
+
+void ObservedValues::recordConstant(Code* caller, SEXP e) {
+    assert(numTypes == 1 && !monomorphicConstant);
+    // Only values which are never updated in place and outlive the code: the
+    // logical singletons and literals from the constant pool. Other scalars
+    // are mostly allocated freshly, a guard on their identity would fail.
+    if (e != R_TrueValue && e != R_FalseValue && !Pool::contains(e))
+        return;
+    ENSURE_NAMEDMAX(e);
+    // Constants seen by other sites are shared
+    unsigned i = 0;
+    while (i < caller->extraPoolSize && caller->getExtraPoolEntry(i) != e)
+        i++;
+    if (i >= MaxConstantIdx)
+        return;
+    uint16_t idx = i;
+    if (i == caller->extraPoolSize)
+        idx = caller->addExtraPoolEntry(e);
+    memcpy(&seen[1], &idx, sizeof(idx));
+    monomorphicConstant = true;
+}
+
+SEXP ObservedValues::constant(const Code* caller) const {
+    return caller->getExtraPoolEntry(constantIdx());
 }
 
 SEXP ObservedCallees::getTarget(const Code* code, size_t pos) const {
@@ -5,6 +5,7 @@
 #include "common.h"
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 
 namespace rir {
@@ -15,11 +16,17 @@ struct Code;
 // contain NaN for the benefit, so we simple assume they do
 static const R_xlen_t MAX_SIZE_OF_VECTOR_FOR_NAN_CHECK = 1;
 
+// Every feedback slot counts the deopts caused by speculating on it (see
+// recordDeoptReason). Once there were PIR_DEOPT_SITE_ABANDON of them, the
+// compiler stops speculating on this slot only.
+static constexpr unsigned DeoptCounterBits = 2;
+static constexpr unsigned MaxSiteDeopts = (1 << DeoptCounterBits) - 1;
+
 #pragma pack(push)
 #pragma pack(1)
 
 struct ObservedCallees {
-    static constexpr unsigned CounterBits = 30;
+    static constexpr unsigned CounterBits = 28;
     static constexpr unsigned CounterOverflow = (1 << CounterBits) - 1;
     static constexpr unsigned TargetBits = 2;
     static constexpr unsigned MaxTargets = (1 << TargetBits) - 1;
@@ -31,10 +38,30 @@ struct ObservedCallees {
     // Effectively this means we have seen MaxTargets or more.
     uint32_t numTargets : TargetBits;
     uint32_t taken : CounterBits;
+    uint32_t deopts : DeoptCounterBits;
 
-    void record(Code* caller, SEXP callee);
+    // Returns true if a new target was recorded
+    bool record(Code* caller, SEXP callee);
+    void recordTaken() {
+        if (taken < CounterOverflow)
+            taken++;
+    }
+    void recordDeopt() {
+        if (deopts < MaxSiteDeopts)
+            deopts++;
+    }
     SEXP getTarget(const Code* code, size_t pos) const;
 
+    // A feedback window only refers to targets of the live feedback, see
+    // FeedbackWindow.
+    bool narrowerThan(const ObservedCallees& live) const {
+        return numTargets > 0 && numTargets < live.numTargets;
+    }
+    void narrowTo(const ObservedCallees& window) {
+        numTargets = window.numTargets;
+        targets = window.targets;
+    }
+
     std::array<unsigned, MaxTargets> targets;
 };
 
@@ -79,26 +106,38 @@ static_assert(sizeof(ObservedCallees) == 4 * sizeof(uint32_t),
 struct ObservedTest {
     enum { None, OnlyTrue, OnlyFalse, Both };
     uint32_t seen : 2;
-    uint32_t unused : 30;
+    uint32_t deopts : DeoptCounterBits;
+    uint32_t unused : 28;
 
-    ObservedTest() : seen(0), unused(0) {}
+    ObservedTest() : seen(0), deopts(0), unused(0) {}
+
+    void recordDeopt() {
+        if (deopts < MaxSiteDeopts)
+            deopts++;
+    }
 
-    RIR_INLINE void record(SEXP e) {
+    bool narrowerThan(const ObservedTest& live) const {
+        return seen != None && seen != Both && live.seen == Both;
+    }
+    void narrowTo(const ObservedTest& window) { seen = window.seen; }
+
+    // Returns true if the feedback changed
+    RIR_INLINE bool record(SEXP e) {
+        auto old = seen;
         if (e == R_TrueValue) {
             if (seen == None)
                 seen = OnlyTrue;
             else if (seen != OnlyTrue)
                 seen = Both;
-            return;
-        }
-        if (e == R_FalseValue) {
+        } else if (e == R_FalseValue) {
             if (seen == None)
                 seen = OnlyFalse;
             else if (seen != OnlyFalse)
                 seen = Both;
-            return;
+        } else {
+            seen = Both;
         }
-        seen = Both;
+        return seen != old;
     }
 };
 static_assert(sizeof(ObservedTest) == sizeof(uint32_t),
@@ -116,16 +155,71 @@ struct ObservedValues {
     static constexpr unsigned MaxTypes = 3;
     uint8_t numTypes : 2;
     uint8_t stateBeforeLastForce : 2;
-    uint8_t unused : 4;
+    // All observed values were simple int, real or logical scalars and none of
+    // them was NA
+    uint8_t notNA : 1;
+    // All observed values were the same simple int, real or logical scalar.
+    // The value is kept in the extra pool of the recording code object, its
+    // index is stored in place of seen[1] and seen[2] (see constantIdx), which
+    // are unused as long as there is only one type.
+    uint8_t monomorphicConstant : 1;
+    uint8_t deopts : DeoptCounterBits;
 
     std::array<ObservedType, MaxTypes> seen;
 
     ObservedValues()
         : numTypes(0), stateBeforeLastForce(StateBeforeLastForce::unknown),
-          unused(0) {}
+          notNA(0), monomorphicConstant(0), deopts(0) {}
 
     void reset() { *this = ObservedValues(); }
 
+    void recordDeopt() {
+        if (deopts < MaxSiteDeopts)
+            deopts++;
+    }
+
+    static constexpr unsigned MaxConstantIdx = UINT16_MAX;
+    uint16_t constantIdx() const {
+        assert(monomorphicConstant && numTypes == 1);
+        uint16_t idx;
+        memcpy(&idx, &seen[1], sizeof(idx));
+        return idx;
+    }
+    SEXP constant(const Code* caller) const;
+
+    // True if every value recorded here was also recorded by live, which
+    // recorded more types or more general ones. With MaxTypes the feedback
+    // might have seen any type.
+    bool narrowerThan(const ObservedValues& live) const {
+        if (numTypes == 0 || numTypes == MaxTypes || (!notNA && live.notNA))
+            return false;
+        if (live.numTypes == MaxTypes)
+            return true;
+        bool narrower = numTypes < live.numTypes || (notNA && !live.notNA);
+        for (size_t i = 0; i < numTypes; ++i) {
+            auto t = seen[i];
+            size_t j = 0;
+            while (j < live.numTypes && live.seen[j].sexptype != t.sexptype)
+                ++j;
+            if (j == live.numTypes)
+                return false;
+            auto l = live.seen[j];
+            if (!((l | t) == l))
+                return false;
+            if (!(l == t))
+                narrower = true;
+        }
+        return narrower;
+    }
+    // Takes the types of a narrower window, keeps the deopt count and the
+    // force behavior
+    void narrowTo(const ObservedValues& window) {
+        numTypes = window.numTypes;
+        seen = window.seen;
+        notNA = window.notNA;
+        monomorphicConstant = false;
+    }
+
     void print(std::ostream& out) const {
         if (numTypes) {
             for (size_t i = 0; i < numTypes; ++i) {
@@ -135,6 +229,12 @@ struct ObservedValues {
                 if (i != (unsigned)numTypes - 1)
                     out << ", ";
             }
+            if (notNA)
+                out << " notNA";
+            if (monomorphicConstant)
+                out << " const";
+            if (deopts)
+                out << " deopts: " << (int)deopts;
             if (stateBeforeLastForce !=
                 ObservedValues::StateBeforeLastForce::unknown) {
                 out << " | "
@@ -152,22 +252,67 @@ struct ObservedValues {
         }
     };
 
-    RIR_INLINE void record(SEXP e) {
+    static bool isNotNAScalar(SEXP e, const ObservedType& type) {
+        if (!type.scalar)
+            return false;
+        switch (type.sexptype) {
+        case INTSXP:
+            return INTEGER(e)[0] != NA_INTEGER;
+        case LGLSXP:
+            return LOGICAL(e)[0] != NA_LOGICAL;
+        case REALSXP:
+            return !ISNAN(REAL(e)[0]);
+        default:
+            return false;
+        }
+    }
+
+    // Returns true if the feedback changed. Constants are only tracked if the
+    // recording code object is passed in.
+    RIR_INLINE bool record(SEXP e, Code* caller = nullptr) {
         ObservedType type(e);
+        if (numTypes == 0) {
+            seen[numTypes++] = type;
+            notNA = isNotNAScalar(e, type);
+            if (caller && notNA)
+                recordConstant(caller, e);
+            return true;
+        }
+
+        bool changed = false;
+        if (notNA && !isNotNAScalar(e, type)) {
+            notNA = false;
+            changed = true;
+        }
+        // Needs to happen before a second type overwrites the constant index
+        if (monomorphicConstant && (!caller || constant(caller) != e)) {
+            monomorphicConstant = false;
+            changed = true;
+        }
+
         if (numTypes < MaxTypes) {
             int i = 0;
             for (; i < numTypes; ++i) {
                 if (seen[i] == type)
                     break;
                 if (seen[i].sexptype == type.sexptype) {
-                    seen[i] = seen[i] | type;
-                    return;
+                    auto merged = seen[i] | type;
+                    if (merged == seen[i])
+                        return changed;
+                    seen[i] = merged;
+                    return true;
                 }
             }
-            if (i == numTypes)
+            if (i == numTypes) {
                 seen[numTypes++] = type;
+                return true;
+            }
         }
+        return changed;
     }
+
+  private:
+    void recordConstant(Code* caller, SEXP e);
 };
 static_assert(sizeof(ObservedValues) == sizeof(uint32_t),
               "Size needs to fit inside a record_ bc immediate args");
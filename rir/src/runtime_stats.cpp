@@ -0,0 +1,68 @@
+#include "runtime_stats.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace rir {
+
+size_t RuntimeStats::counters[NumCounters];
+
+static const char* statsFile = getenv("RIR_STATS_FILE");
+static double statsInterval =
+    getenv("RIR_STATS_INTERVAL") ? atof(getenv("RIR_STATS_INTERVAL")) : 0;
+
+typedef std::chrono::steady_clock Clock;
+static Clock::time_point startTime = Clock::now();
+static Clock::time_point lastDump = startTime;
+
+static double seconds(Clock::time_point t) {
+    return std::chrono::duration<double>(t - startTime).count();
+}
+
+static void dumpToFile(Clock::time_point now) {
+    std::ofstream file(statsFile, std::ios::app);
+    RuntimeStats::dump(file, seconds(now));
+    lastDump = now;
+}
+
+namespace {
+struct DumpAtExit {
+    ~DumpAtExit() {
+        if (statsFile)
+            dumpToFile(Clock::now());
+    }
+};
+} // namespace
+static DumpAtExit dumpAtExit;
+
+const char* RuntimeStats::name(Counter c) {
+    switch (c) {
+#define V(counter, name)                                                       \
+    case counter:                                                              \
+        return name;
+        LIST_OF_RUNTIME_STATS(V)
+#undef V
+    case NumCounters:
+        break;
+    }
+    return "";
+}
+
+void RuntimeStats::reset() { memset(counters, 0, sizeof(counters)); }
+
+void RuntimeStats::tick() {
+    if (!statsFile || statsInterval <= 0)
+        return;
+    auto now = Clock::now();
+    if (std::chrono::duration<double>(now - lastDump).count() >= statsInterval)
+        dumpToFile(now);
+}
+
+void RuntimeStats::dump(std::ostream& out, double time) {
+    for (unsigned i = 0; i < NumCounters; ++i)
+        out << time << ", " << name((Counter)i) << ", " << counters[i] << "\n";
+}
+
+} // namespace rir
@@ -0,0 +1,67 @@
+#ifndef RIR_RUNTIME_STATS_H
+#define RIR_RUNTIME_STATS_H
+
+#include <cstddef>
+#include <ostream>
+
+namespace rir {
+
+#define LIST_OF_RUNTIME_STATS(V)                                               \
+    V(Compilations, "compilations")                                            \
+    V(CompileFailures, "compile.failures")                                     \
+    V(FailedMinimalContext, "compile.failures.minimal_context")               \
+    V(FailedDots, "compile.failures.dots")                                     \
+    V(FailedHugeFunction, "compile.failures.huge_function")                    \
+    V(FailedDefaultArg, "compile.failures.default_arg")                        \
+    V(FailedRir2Pir, "compile.failures.rir2pir")                               \
+    V(TranslationCacheHits, "compile.translation_cache.hits")                  \
+    V(Deopts, "deopts")                                                        \
+    V(DeoptTypecheck, "deopts.typecheck")                                      \
+    V(DeoptCalltarget, "deopts.calltarget")                                    \
+    V(DeoptEnvStubMaterialized, "deopts.env_stub_materialized")                \
+    V(DeoptDeadBranchReached, "deopts.dead_branch_reached")                    \
+    V(DeoptlessContinuations, "deopts.continued")                              \
+    V(DeoptlessCompilations, "deopts.continuations_compiled")                  \
+    V(DispatchMisses, "dispatch.misses")                                       \
+    V(DispatchTableEvictions, "dispatch.evictions")                            \
+    V(FeedbackWindows, "feedback.windows")                                     \
+    V(FeedbackPhaseChanges, "feedback.phase_changes")                          \
+    V(EnvMaterializations, "env.materializations")                             \
+    V(PromiseAllocations, "promise.allocations")                               \
+    V(BuiltinSlowcases, "builtin.slowcases")                                   \
+    V(SpecialSlowcases, "special.slowcases")                                   \
+    V(NativeCodeBytes, "native.code.bytes")                                    \
+    V(NativeBoxes, "native.boxes")
+
+/*
+ * Counters of the behavior of the JIT, which are cheap enough to be always on
+ * (unlike EventCounters, which only exist in MEASURE builds).
+ *
+ * They are read by rir.stats(). If RIR_STATS_FILE is set, they are appended
+ * to this file at exit and every RIR_STATS_INTERVAL seconds.
+ */
+class RuntimeStats {
+  public:
+    enum Counter : unsigned {
+#define V(counter, name) counter,
+        LIST_OF_RUNTIME_STATS(V)
+#undef V
+            NumCounters
+    };
+
+    static void count(Counter c, size_t n = 1) { counters[c] += n; }
+    static size_t get(Counter c) { return counters[c]; }
+    static const char* name(Counter c);
+    static void reset();
+
+    // Called at safepoints of the interpreter, does the periodic dump
+    static void tick();
+    static void dump(std::ostream& out, double time);
+
+  private:
+    static size_t counters[NumCounters];
+};
+
+} // namespace rir
+
+#endif
@@ -36,8 +36,8 @@ class EnumSet {
     static constexpr Store AnyI() { return static_cast<Store>(Any()); }
 
     static constexpr EnumSet Any() {
-        return EnumSet(((1 << ((Store)(Element::LAST) + 1)) - 1) &
-                       ~((1 << (Store)Element::FIRST) - 1));
+        return EnumSet((((Store)1 << (Store)(Element::LAST)) * 2 - 1) &
+                       ~(((Store)1 << (Store)Element::FIRST) - 1));
     }
 
     constexpr EnumSet() {}
@@ -133,7 +133,7 @@ class EnumSet {
 
     RIR_INLINE constexpr bool empty() const { return set_ == 0; }
 
-    RIR_INLINE std::size_t count() const { return __builtin_popcount(set_); }
+    RIR_INLINE std::size_t count() const { return __builtin_popcountl(set_); }
 
     struct Iterator {
       private:
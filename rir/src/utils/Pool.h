@@ -32,6 +32,8 @@ class Pool {
         return i;
     }
 
+    static bool contains(SEXP e) { return contents.count(e); }
+
     static BC::PoolIdx makeSpace() {
         size_t i = cp_pool_add(globalContext(), R_NilValue);
         return i;
@@ -0,0 +1,95 @@
+#ifndef RIR_SMALL_VECTOR_H
+#define RIR_SMALL_VECTOR_H
+
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+
+namespace rir {
+
+// Vector which keeps up to N elements inline and only goes to the heap if it
+// grows beyond. T needs to be default constructible and copy assignable.
+template <typename T, size_t N>
+class SmallVector {
+    T* data_;
+    size_t size_ = 0;
+    size_t capacity_ = N;
+    T inline_[N];
+
+    bool isInline() const { return data_ == inline_; }
+
+    void grow() {
+        capacity_ *= 2;
+        auto data = new T[capacity_];
+        for (size_t i = 0; i < size_; ++i)
+            data[i] = data_[i];
+        if (!isInline())
+            delete[] data_;
+        data_ = data;
+    }
+
+  public:
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    SmallVector() : data_(inline_) {}
+    SmallVector(std::initializer_list<T> in) : data_(inline_) {
+        for (const auto& e : in)
+            push_back(e);
+    }
+    SmallVector(const SmallVector& other) : data_(inline_) {
+        for (const auto& e : other)
+            push_back(e);
+    }
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            size_ = 0;
+            for (const auto& e : other)
+                push_back(e);
+        }
+        return *this;
+    }
+    ~SmallVector() {
+        if (!isInline())
+            delete[] data_;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    void push_back(const T& e) {
+        if (size_ == capacity_) {
+            // e might point into the buffer which grow() frees
+            T copy = e;
+            grow();
+            data_[size_++] = copy;
+            return;
+        }
+        data_[size_++] = e;
+    }
+    void pop_back() {
+        assert(size_ > 0);
+        data_[--size_] = T();
+    }
+
+    T& operator[](size_t pos) { return data_[pos]; }
+    const T& operator[](size_t pos) const { return data_[pos]; }
+    T& back() { return data_[size_ - 1]; }
+    const T& back() const { return data_[size_ - 1]; }
+
+    iterator erase(iterator pos) {
+        for (auto i = pos; i + 1 != end(); ++i)
+            *i = *(i + 1);
+        pop_back();
+        return pos;
+    }
+
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+};
+
+} // namespace rir
+
+#endif